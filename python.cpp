@@ -73,6 +73,7 @@ static bool g_instance_initialized = false; // This instance of the plugin is th
                                             // that initialized the python interpreter.
 static int  g_run_when = -1;
 static char g_run_script[QMAXPATH];
+static char g_profile_file[QMAXPATH];
 static char g_idapython_dir[QMAXPATH];
 
 //-------------------------------------------------------------------------
@@ -119,9 +120,12 @@ static int ninsns = 0;      // number of times trace function was called
 static bool box_displayed;  // has the wait box been displayed?
 static time_t start_time;   // the start time of the execution
 static int script_timeout = 2;
+static int script_break_mode = SCRIPT_BREAK_TRACE;
 static bool g_ui_ready = false;
 static bool g_alert_auto_scripts = true;
 static bool g_remove_cwd_sys_path = false;
+static bool g_lazy_imports = false;
+static bool g_print_startup_times = false;
 static bool g_use_local_python = false;
 
 static void end_execution(void);
@@ -167,6 +171,97 @@ static void reset_execution_time()
   ninsns = 0;
 }
 
+//------------------------------------------------------------------------
+// The watchdog alternative to break_check(): instead of having a trace
+// function called on every interpreter event, a thread wakes up
+// periodically and, only when there is something to do, schedules
+// watchdog_check() to be run by the interpreter on the main thread.
+static volatile bool watchdog_armed = false;   // a script is being executed
+static volatile bool watchdog_pending = false; // watchdog_check() is scheduled
+static volatile bool watchdog_stop = false;
+static qthread_t watchdog_thread = NULL;
+static qsemaphore_t watchdog_sem = NULL;
+
+//------------------------------------------------------------------------
+// Runs on the main thread, from the interpreter loop
+static int watchdog_check(void *)
+{
+  watchdog_pending = false;
+  if ( !watchdog_armed )
+    return 0;
+  if ( wasBreak() )
+  {
+    // User pressed Cancel in the waitbox; send KeyboardInterrupt exception
+    PyErr_SetString(PyExc_KeyboardInterrupt, "User interrupted");
+    return -1;
+  }
+  if ( !box_displayed
+    && script_timeout != 0
+    && time(NULL) - start_time > script_timeout )
+  {
+    box_displayed = true;
+    show_wait_box("Running Python script");
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------
+static int idaapi watchdog_cb(void *)
+{
+  while ( !watchdog_stop )
+  {
+    // Sleep until a script runs; then poll, and more often once the
+    // wait box is displayed
+    qsem_wait(watchdog_sem, !watchdog_armed ? -1 : box_displayed ? 50 : 250);
+    if ( watchdog_stop || !watchdog_armed || watchdog_pending )
+      continue;
+    if ( box_displayed
+      || (script_timeout != 0 && time(NULL) - start_time > script_timeout) )
+    {
+      // Py_AddPendingCall() doesn't need the GIL
+      watchdog_pending = true;
+      if ( Py_AddPendingCall(watchdog_check, NULL) != 0 )
+        watchdog_pending = false;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------
+static bool start_watchdog()
+{
+  if ( watchdog_thread != NULL )
+    return true;
+  if ( watchdog_sem == NULL )
+  {
+    watchdog_sem = qsem_create(NULL, 0);
+    if ( watchdog_sem == NULL )
+      return false;
+  }
+  watchdog_stop = false;
+  watchdog_thread = qthread_create(watchdog_cb, NULL);
+  return watchdog_thread != NULL;
+}
+
+//------------------------------------------------------------------------
+static void stop_watchdog()
+{
+  watchdog_armed = false;
+  if ( watchdog_thread != NULL )
+  {
+    watchdog_stop = true;
+    qsem_post(watchdog_sem);
+    qthread_join(watchdog_thread);
+    qthread_free(watchdog_thread);
+    watchdog_thread = NULL;
+  }
+  if ( watchdog_sem != NULL )
+  {
+    qsem_free(watchdog_sem);
+    watchdog_sem = NULL;
+  }
+}
+
 //------------------------------------------------------------------------
 // Prepare for Python execution
 static void begin_execution()
@@ -177,7 +272,13 @@ static void begin_execution()
   PYW_GIL_CHECK_LOCKED_SCOPE();
   end_execution();
   reset_execution_time();
-  PyEval_SetTrace(break_check, NULL);
+  if ( script_break_mode == SCRIPT_BREAK_WATCHDOG && start_watchdog() )
+  {
+    watchdog_armed = true;
+    qsem_post(watchdog_sem);
+  }
+  else
+    PyEval_SetTrace(break_check, NULL);
 }
 
 //---------------------------------------------------------------------------
@@ -194,6 +295,7 @@ static void hide_script_waitbox()
 // Called after Python execution finishes
 static void end_execution()
 {
+  watchdog_armed = false;
   hide_script_waitbox();
   PYW_GIL_CHECK_LOCKED_SCOPE();
 #ifdef ENABLE_PYTHON_PROFILING
@@ -242,6 +344,39 @@ int set_script_timeout(int timeout)
   return timeout;
 }
 
+//-------------------------------------------------------------------------
+//lint -esym(714,set_script_break_mode) Symbol not referenced
+int set_script_break_mode(int mode)
+{
+  if ( mode != SCRIPT_BREAK_TRACE && mode != SCRIPT_BREAK_WATCHDOG )
+    return -1;
+  qswap(mode, script_break_mode);
+  return mode;
+}
+
+//-------------------------------------------------------------------------
+// Calls 'py_callable' with the checks that a script gets in the given
+// script break mode, or without any check if 'mode' is -1.
+// The checks of the calling script are suspended in the meantime, and
+// restarted afterwards (with a fresh timeout).
+// Used by the benchmark of the script break modes (driver_break.cpp).
+PyObject *pywraps_call_with_script_break(PyObject *py_callable, int mode)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  end_execution();
+  int old_mode = script_break_mode;
+  if ( mode != -1 )
+  {
+    script_break_mode = mode;
+    begin_execution();
+  }
+  PyObject *py_res = PyObject_CallObject(py_callable, NULL);
+  end_execution();
+  script_break_mode = old_mode;
+  begin_execution();
+  return py_res;
+}
+
 //------------------------------------------------------------------------
 // Return a formatted error or just print it to the console
 static void handle_python_error(
@@ -277,8 +412,16 @@ static void PythonEvalOrExec(
 {
   // Compile as an expression
   PYW_GIL_CHECK_LOCKED_SCOPE();
-  PyCompilerFlags cf = {0};
-  newref_t py_code(Py_CompileStringFlags(str, filename, Py_eval_input, &cf));
+  ref_t py_code;
+  if ( streq(filename, "<string>") )
+  {
+    py_code = newref_t(pywraps_compile_cached(str, Py_eval_input));
+  }
+  else
+  {
+    PyCompilerFlags cf = {0};
+    py_code = newref_t(Py_CompileStringFlags(str, filename, Py_eval_input, &cf));
+  }
   if ( py_code == NULL || PyErr_Occurred() )
   {
     // Not an expression?
@@ -346,11 +489,10 @@ static bool idaapi IDAPython_extlang_run_statements(
     errbuf[0] = '\0';
     PyErr_Clear();
     begin_execution();
-    newref_t result(PyRun_String(
-                            str,
-                            Py_file_input,
-                            globals,
-                            globals));
+    ref_t result;
+    newref_t py_code(pywraps_compile_cached(str, Py_file_input));
+    if ( py_code != NULL )
+      result = newref_t(PyEval_EvalCode((PyCodeObject *)py_code.o, globals, globals));
     end_execution();
     ok = result != NULL && !PyErr_Occurred();
     if ( !ok )
@@ -394,6 +536,11 @@ const char *idaapi set_python_options(
         script_timeout = int(*(uval_t *)value);
         break;
       }
+      else if ( qstrcmp(keyword, "SCRIPT_BREAK_MODE") == 0 )
+      {
+        set_script_break_mode(int(*(uval_t *)value));
+        break;
+      }
       else if ( qstrcmp(keyword, "ALERT_AUTO_SCRIPTS") == 0 )
       {
         g_alert_auto_scripts = *(uval_t *)value != 0;
@@ -404,6 +551,16 @@ const char *idaapi set_python_options(
         g_remove_cwd_sys_path = *(uval_t *)value != 0;
         break;
       }
+      else if ( qstrcmp(keyword, "LAZY_IMPORTS") == 0 )
+      {
+        g_lazy_imports = *(uval_t *)value != 0;
+        break;
+      }
+      else if ( qstrcmp(keyword, "PRINT_STARTUP_TIMES") == 0 )
+      {
+        g_print_startup_times = *(uval_t *)value != 0;
+        break;
+      }
       else if ( qstrcmp(keyword, "USE_LOCAL_PYTHON") == 0 )
       {
         msg("\"USE_LOCAL_PYTHON\" is deprecated. IDA will always use "
@@ -1096,7 +1253,9 @@ bool idaapi IDAPython_extlang_calcexpr(
   if ( ok )
   {
     begin_execution();
-    result = newref_t(PyRun_String(expr, Py_eval_input, globals, globals));
+    newref_t py_code(pywraps_compile_cached(expr, Py_eval_input));
+    if ( py_code != NULL )
+      result = newref_t(PyEval_EvalCode((PyCodeObject *)py_code.o, globals, globals));
     end_execution();
     ok = return_python_result(rv, result, errbuf, errbufsize);
   }
@@ -1307,6 +1466,32 @@ void parse_plugin_options()
   if ( options == NULL )
     return;
 
+  // User asked for the script to be profiled?
+  // profile=<outfile>[,<interval_ms>];[<when>;]<script>
+  static const char profile_opt[] = "profile=";
+  if ( strneq(options, profile_opt, sizeof(profile_opt) - 1) )
+  {
+    const char *spec = options + sizeof(profile_opt) - 1;
+    const char *end = strchr(spec, ';');
+    if ( end == NULL )
+      end = tail(spec);
+    char buf[QMAXPATH];
+    qstrncpy(buf, spec, qmin(size_t(end - spec) + 1, sizeof(buf)));
+    int interval_ms = 10;
+    char *comma = strrchr(buf, ',');
+    if ( comma != NULL )
+    {
+      *comma = '\0';
+      interval_ms = atoi(comma + 1);
+    }
+    qstrncpy(g_profile_file, buf, sizeof(g_profile_file));
+    if ( !pywraps_profiler_start(interval_ms) )
+      msg("IDAPython: could not start the profiler\n");
+    if ( *end == '\0' )
+      return;
+    options = end + 1;
+  }
+
   // User specified 'when' parameter?
   const char *p = strchr(options, ';');
   if ( p == NULL )
@@ -1533,12 +1718,16 @@ bool IDAPython_Init(void)
   if ( Py_IsInitialized() != 0 )
     return true;
 
+  // Time the startup phases (idaapi.get_startup_profile())
+  pywraps_startup_phase(NULL);
+
   // Form the absolute path to IDA\python folder
   qstrncpy(g_idapython_dir, idadir(PYTHON_DIR_NAME), sizeof(g_idapython_dir));
 
   // Check for the presence of essential files
   if ( !check_python_dir() )
     return false;
+  pywraps_startup_phase("check_python_dir");
 
   char tmp[QMAXPATH];
 #ifdef __LINUX__
@@ -1576,6 +1765,7 @@ bool IDAPython_Init(void)
 
   // Read configuration value
   read_user_config_file("python.cfg", set_python_options, NULL);
+  pywraps_startup_phase("python.cfg");
   if ( g_alert_auto_scripts )
   {
     if ( pywraps_check_autoscripts(tmp, sizeof(tmp))
@@ -1584,6 +1774,7 @@ bool IDAPython_Init(void)
     {
       return false;
     }
+    pywraps_startup_phase("check_autoscripts");
   }
 
   if ( g_use_local_python )
@@ -1613,23 +1804,35 @@ bool IDAPython_Init(void)
     warning("IDAPython: Py_InitializeEx() failed");
     return false;
   }
+  pywraps_startup_phase("Py_InitializeEx");
 
   // remove current directory
   sanitize_path();
+  pywraps_startup_phase("sanitize_path");
 
   // import "site"
-  if ( !g_use_local_python && !initsite() )
+  if ( !g_use_local_python )
   {
-    warning("IDAPython: importing \"site\" failed");
-    return false;
+    if ( !initsite() )
+    {
+      warning("IDAPython: importing \"site\" failed");
+      return false;
+    }
+    pywraps_startup_phase("initsite");
   }
 
   // Enable multi-threading support
   if ( !PyEval_ThreadsInitialized() )
     PyEval_InitThreads();
 
+  // The main thread state lives until Py_Finalize(): let gil_lock_t
+  // skip PyGILState_Ensure() when the main thread holds the GIL
+  gil_tls.tstate = PyThreadState_Get();
+  gil_tls.permanent = true;
+
   // Init the SWIG wrapper
   init_idaapi();
+  pywraps_startup_phase("init_idaapi");
 
 #ifdef Py_DEBUG
   msg("HexraysPython: Python compiled with DEBUG enabled.\n");
@@ -1640,13 +1843,17 @@ bool IDAPython_Init(void)
           tmp,
           sizeof(tmp),
           "IDAPYTHON_VERSION=(%d, %d, %d, '%s', %d)\n"
-          "IDAPYTHON_REMOVE_CWD_SYS_PATH = %s\n",
+          "IDAPYTHON_REMOVE_CWD_SYS_PATH = %s\n"
+          "IDAPYTHON_LAZY_IMPORTS = %s\n"
+          "IDAPYTHON_PRINT_STARTUP_TIMES = %s\n",
           VER_MAJOR,
           VER_MINOR,
           VER_PATCH,
           VER_STATUS,
           VER_SERIAL,
-          g_remove_cwd_sys_path ? "True" : "False");
+          g_remove_cwd_sys_path ? "True" : "False",
+          g_lazy_imports ? "True" : "False",
+          g_print_startup_times ? "True" : "False");
   PyRun_SimpleString(tmp);
 
   // Install extlang. Needs to be done before running init.py
@@ -1671,14 +1878,24 @@ bool IDAPython_Init(void)
     remove_extlang(&extlang_python);
     return false;
   }
+  pywraps_startup_phase(S_INIT_PY);
 
   // Init pywraps and notify_when
-  if ( !init_pywraps() || !pywraps_nw_init() )
+  bool ok = init_pywraps();
+  pywraps_startup_phase("init_pywraps");
+  if ( !ok || !pywraps_nw_init() )
   {
     warning("IDAPython: init_pywraps() failed!");
     remove_extlang(&extlang_python);
     return false;
   }
+  pywraps_startup_phase("pywraps_nw_init");
+
+  // Start the native worker threads (scanning functions fall back to
+  // the main thread if they can't be started)
+  if ( !pywraps_workers_init() )
+    msg("IDAPython: could not start the worker threads\n");
+  pywraps_startup_phase("pywraps_workers_init");
 
 #ifdef ENABLE_PYTHON_PROFILING
   PyEval_SetTrace(tracefunc, NULL);
@@ -1694,9 +1911,14 @@ bool IDAPython_Init(void)
           idc_runpythonstatement_args,
           0);
 
+  pywraps_startup_phase("parse_plugin_options");
+
   // A script specified on the command line is run
   if ( g_run_when == run_on_init )
+  {
     RunScript(g_run_script);
+    pywraps_startup_phase("run_on_init script");
+  }
 
 #ifdef _DEBUG
   hook_to_notification_point(HT_UI, ui_debug_handler_cb, NULL);
@@ -1707,7 +1929,10 @@ bool IDAPython_Init(void)
   // Enable the CLI by default
   enable_python_cli(true);
 
+  pywraps_startup_phase("hooks and CLI");
+
   pywraps_nw_notify(NW_INITIDA_SLOT);
+  pywraps_startup_dump();
 
   PyEval_ReleaseThread(PyThreadState_Get());
 
@@ -1747,9 +1972,22 @@ void IDAPython_Term(void)
   // Remove the CLI
   enable_python_cli(false);
 
+  // Stop the script timeout watchdog
+  stop_watchdog();
+
+  // Stop the profiler (its sampler thread must not outlive Py_Finalize()),
+  // and save its stacks if it was started from the command line
+  pywraps_profiler_stop(g_profile_file[0] != '\0' ? g_profile_file : NULL);
+
   // Remove the extlang
   remove_extlang(&extlang_python);
 
+  // Stop the native worker threads
+  pywraps_workers_term();
+
+  // Release the cached code objects
+  pywraps_code_cache_flush();
+
   // De-init pywraps
   deinit_pywraps();
 
@@ -1757,6 +1995,8 @@ void IDAPython_Term(void)
   set_idc_func_ex(S_IDC_RUNPYTHON_STATEMENT, NULL, NULL, 0);
 
   // Shut the interpreter down
+  gil_tls.tstate = NULL;
+  gil_tls.permanent = false;
   Py_Finalize();
   g_instance_initialized = false;
 }
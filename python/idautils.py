@@ -15,6 +15,18 @@ import idaapi
 import idc
 import types
 import os
+import array
+
+
+def _ea_batches(it):
+    """
+    Flattens the batches of an idaapi.ea_batch_iterator_t - INTERNAL USE ONLY.
+    """
+    batch = it.next_batch()
+    while batch:
+        for ea in batch:
+            yield ea
+        batch = it.next_batch()
 
 
 def refs(ea, funcfirst, funcnext):
@@ -180,18 +192,35 @@ def Threads():
         yield idc.GetThreadId(i)
 
 
-def Heads(start=None, end=None):
+def Heads(start=None, end=None, as_array=False, batch=False):
     """
     Get a list of heads (instructions or data)
 
     @param start: start address (default: inf.minEA)
     @param end:   end address (default: inf.maxEA)
+    @param as_array: return all the heads at once, as an array.array
+    @param batch: fetch the heads natively, by batches of up to 1024
 
     @return: list of heads between start and end
+
+    @note: By default, the next head is looked up at each step, thus the
+    database may be modified while iterating. With 'as_array' or 'batch',
+    the heads are a snapshot (of the whole range, or of the current batch):
+    do not use them if the loop creates or deletes items.
     """
     if not start: start = idaapi.cvar.inf.minEA
     if not end:   end = idaapi.cvar.inf.maxEA
 
+    if as_array or batch:
+        it = idaapi.ea_batch_iterator_t(idaapi.EABI_HEADS, start, end)
+        return it.to_array() if as_array else _ea_batches(it)
+    return _heads(start, end)
+
+
+def _heads(start, end):
+    """
+    Lazy walk of the heads - INTERNAL USE ONLY.
+    """
     ea = start
     if not idc.isHead(idc.GetFlags(ea)):
         ea = idaapi.next_head(ea, end)
@@ -200,12 +229,14 @@ def Heads(start=None, end=None):
         ea = idaapi.next_head(ea, end)
 
 
-def Functions(start=None, end=None):
+def Functions(start=None, end=None, as_array=False, batch=False):
     """
     Get a list of functions
 
     @param start: start address (default: inf.minEA)
     @param end:   end address (default: inf.maxEA)
+    @param as_array: return all the functions at once, as an array.array
+    @param batch: fetch the functions natively, by batches of up to 1024
 
     @return: list of heads between start and end
 
@@ -213,10 +244,25 @@ def Functions(start=None, end=None):
     if it extends beyond 'end'. Any function that has its chunks scattered
     in multiple segments will be reported multiple times, once in each segment
     as they are listed.
+
+    @note: By default, the next function is looked up at each step, thus
+    functions may be created or deleted while iterating. With 'as_array'
+    or 'batch', the functions are a snapshot (of the whole range, or of the
+    current batch).
     """
     if not start: start = idaapi.cvar.inf.minEA
     if not end:   end = idaapi.cvar.inf.maxEA
 
+    if as_array or batch:
+        it = idaapi.ea_batch_iterator_t(idaapi.EABI_FUNCTIONS, start, end)
+        return it.to_array() if as_array else _ea_batches(it)
+    return _functions(start, end)
+
+
+def _functions(start, end):
+    """
+    Lazy walk of the functions - INTERNAL USE ONLY.
+    """
     # find first function head chunk in the range
     chunk = idaapi.get_fchunk(start)
     if not chunk:
@@ -231,14 +277,30 @@ def Functions(start=None, end=None):
         func = idaapi.get_next_func(startea)
 
 
-def Chunks(start):
+def Chunks(start, as_array=False, batch=False):
     """
     Get a list of function chunks
 
     @param start: address of the function
+    @param as_array: return all the chunks at once, as an array.array
+                     of consecutive start_ea, end_ea values
+    @param batch: fetch the chunks natively, by batches
 
     @return: list of funcion chunks (tuples of the form (start_ea, end_ea))
              belonging to the function
+
+    @note: With 'as_array' or 'batch', the chunks are a snapshot: do not
+    use them if the loop appends or removes function tails.
+    """
+    if as_array or batch:
+        it = idaapi.ea_batch_iterator_t(idaapi.EABI_CHUNKS, start)
+        return it.to_array() if as_array else _chunk_pairs(it)
+    return _chunks(start)
+
+
+def _chunks(start):
+    """
+    Lazy walk of the function chunks - INTERNAL USE ONLY.
     """
     func_iter = idaapi.func_tail_iterator_t( idaapi.get_func( start ) )
     status = func_iter.main()
@@ -248,6 +310,17 @@ def Chunks(start):
         status = func_iter.next()
 
 
+def _chunk_pairs(it):
+    """
+    Pairs the flattened chunk bounds of an ea_batch_iterator_t - INTERNAL USE ONLY.
+    """
+    batch = it.next_batch()
+    while batch:
+        for i in xrange(0, len(batch), 2):
+            yield (batch[i], batch[i+1])
+        batch = it.next_batch()
+
+
 def Modules():
     """
     Returns a list of module objects with name,size,base and the rebase_to attributes
@@ -297,13 +370,28 @@ def Entries():
         yield (i, ordinal, ea, name)
 
 
-def FuncItems(start):
+def FuncItems(start, as_array=False, batch=False):
     """
     Get a list of function items
 
     @param start: address of the function
+    @param as_array: return all the items at once, as an array.array
+    @param batch: fetch the items natively, by batches of up to 1024
 
     @return: ea of each item in the function
+
+    @note: With 'as_array' or 'batch', the items are a snapshot: do not
+    use them if the loop creates or deletes instructions in the function.
+    """
+    if as_array or batch:
+        it = idaapi.ea_batch_iterator_t(idaapi.EABI_FUNC_ITEMS, start)
+        return it.to_array() if as_array else _ea_batches(it)
+    return _func_items(start)
+
+
+def _func_items(start):
+    """
+    Lazy walk of the function items - INTERNAL USE ONLY.
     """
     func = idaapi.get_func(start)
     if not func:
@@ -395,10 +483,30 @@ def DecodeInstruction(ea):
     return idaapi.cmd.copy()
 
 
+def _array_typecode(itemsize):
+    """
+    Returns the unsigned array.array typecode of the given size - INTERNAL USE ONLY.
+    """
+    for typecode in "BHIL":
+        if array.array(typecode).itemsize == itemsize:
+            return typecode
+    return None
+
+
 def GetDataList(ea, count, itemsize=1):
     """
     Get data list - INTERNAL USE ONLY
     """
+    typecode = _array_typecode(itemsize)
+    if typecode:
+        return iter(idaapi.read_array(ea, count, typecode))
+    return _GetDataListSlow(ea, count, itemsize)
+
+
+def _GetDataListSlow(ea, count, itemsize):
+    """
+    Item by item GetDataList() - INTERNAL USE ONLY
+    """
     if itemsize == 1:
         getdata = idaapi.get_byte
     elif itemsize == 2:
@@ -421,6 +529,13 @@ def PutDataList(ea, datalist, itemsize=1):
     """
     Put data list - INTERNAL USE ONLY
     """
+    typecode = _array_typecode(itemsize)
+    if typecode:
+        # Truncate the values, as the patch_xxx() functions do
+        mask = (1 << (8 * itemsize)) - 1
+        idaapi.patch_array(ea, array.array(typecode, [v & mask for v in datalist]))
+        return
+
     putdata = None
 
     if itemsize == 1:
@@ -429,8 +544,10 @@ def PutDataList(ea, datalist, itemsize=1):
         putdata = idaapi.patch_word
     if itemsize == 4:
         putdata = idaapi.patch_long
+    if itemsize == 8:
+        putdata = idaapi.patch_qword
 
-    assert putdata, "Invalid data size! Must be 1, 2 or 4"
+    assert putdata, "Invalid data size! Must be 1, 2, 4 or 8"
 
     for val in datalist:
         putdata(ea, val)
@@ -20,6 +20,22 @@ import _idaapi
 # __EA64__ is set if IDA is running in 64-bit mode
 __EA64__ = _idaapi.BADADDR == 0xFFFFFFFFFFFFFFFFL
 
+# -----------------------------------------------------------------------
+# Startup phases timing, reported by print_banner()
+# -----------------------------------------------------------------------
+_startup_timer = time.clock if sys.platform == "win32" else time.time
+_startup_phases = []
+_startup_t0 = _startup_timer()
+
+def _startup_phase(name):
+    """
+    Ends the current startup phase
+    """
+    global _startup_t0
+    t = _startup_timer()
+    _startup_phases.append((name, t - _startup_t0))
+    _startup_t0 = t
+
 # -----------------------------------------------------------------------
 # Take over the standard text outputs
 # -----------------------------------------------------------------------
@@ -38,6 +54,34 @@ class IDAPythonStdOut:
     def isatty(self):
         return False
 
+# -----------------------------------------------------------------------
+class IDAPythonLazyModule(object):
+    """
+    Stands for a module in the globals until one of its attributes is
+    accessed. The module is then imported and takes its place.
+    """
+    def __init__(self, name):
+        self.__dict__["_name"] = name
+
+    def _load(self):
+        m = __import__(self._name)
+        g = globals()
+        if g.get(self._name) is self:
+            g[self._name] = m
+        return m
+
+    def __getattr__(self, attr):
+        return getattr(self._load(), attr)
+
+    def __setattr__(self, attr, value):
+        setattr(self._load(), attr, value)
+
+    def __dir__(self):
+        return dir(self._load())
+
+    def __repr__(self):
+        return "<lazy module '%s'>" % self._name
+
 # -----------------------------------------------------------------------
 def runscript(script):
     """
@@ -63,6 +107,24 @@ def print_banner():
     print(sepline)
     print("\n".join(banner))
     print(sepline)
+    if IDAPYTHON_PRINT_STARTUP_TIMES:
+        print_startup_times()
+
+# -----------------------------------------------------------------------
+def print_startup_times():
+    """
+    Prints the time taken by the startup phases (idaapi.get_startup_profile()),
+    with the phases of init.py
+    """
+    profile = idaapi.get_startup_profile()
+    print("IDAPython startup%s: %.1fms" % (
+        " (lazy imports)" if IDAPYTHON_LAZY_IMPORTS else "",
+        sum([ns for _, ns in profile]) / 1e6))
+    for name, ns in profile:
+        print("  %-40s %8.1fms" % (name, ns / 1e6))
+        if name == "init.py":
+            for sub, t in _startup_phases:
+                print("    %-38s %8.1fms" % (sub, t * 1000))
 
 # -----------------------------------------------------------------------
 
@@ -70,15 +132,40 @@ def print_banner():
 _orig_stdout = sys.stdout;
 _orig_stderr = sys.stderr;
 sys.stdout = sys.stderr = IDAPythonStdOut()
+_startup_phase("stdout")
 
 # -----------------------------------------------------------------------
 # Initialize the help, with our own stdin wrapper, that'll query the user
 # -----------------------------------------------------------------------
-import pydoc
 class IDAPythonHelpPrompter:
     def readline(self):
         return idaapi.askstr(0, '', 'Help topic?')
-help = pydoc.Helper(input = IDAPythonHelpPrompter(), output = sys.stdout)
+
+def _create_help():
+    import pydoc
+    return pydoc.Helper(input = IDAPythonHelpPrompter(), output = sys.stdout)
+
+class IDAPythonLazyHelper(object):
+    """
+    Creates the help on its first use, and takes its place
+    """
+    def _load(self):
+        global help
+        if help is self:
+            help = _create_help()
+        return help
+
+    def __call__(self, *args, **kwds):
+        return self._load()(*args, **kwds)
+
+    def __repr__(self):
+        return repr(self._load())
+
+if IDAPYTHON_LAZY_IMPORTS:
+    help = IDAPythonLazyHelper()
+else:
+    help = _create_help()
+_startup_phase("help")
 
 # Assign a default sys.argv
 sys.argv = [""]
@@ -96,16 +183,27 @@ if os.getcwd() in sys.path:
 # ...and add it to the end if needed
 if not IDAPYTHON_REMOVE_CWD_SYS_PATH:
     sys.path.append(os.getcwd())
+_startup_phase("sys.path")
 
 # Import all the required modules
 from idaapi import Choose, get_user_idadir, cvar, Choose2, Appcall, Form
-from idc      import *
-from idautils import *
 import idaapi
+_startup_phase("idaapi")
+
+# In the lazy imports mode, 'idc' and 'idautils' are imported on their
+# first use, and their contents are not imported in the globals
+if IDAPYTHON_LAZY_IMPORTS:
+    idc      = IDAPythonLazyModule("idc")
+    idautils = IDAPythonLazyModule("idautils")
+else:
+    from idc      import *
+    from idautils import *
+_startup_phase("idc/idautils")
 
 # Load the users personal init file
 userrc = os.path.join(get_user_idadir(), "idapythonrc.py")
 if os.path.exists(userrc):
     idaapi.IDAPython_ExecScript(userrc, globals())
+    _startup_phase("idapythonrc")
 
 # All done, ready to rock.
@@ -59,18 +59,49 @@
 #define CIP_OK_OPAQUE    2 // Success, but the data pointed to by the PyObject* is an opaque object.
 
 //---------------------------------------------------------------------------
+// The thread state of the current thread, while it is known to be alive:
+// for good on the main thread (see IDAPython_Init()), and while an outer
+// gil_lock_t holds it on the other threads.
+// This lets gil_lock_t tell whether the thread holds the GIL already
+// (e.g., a script calls a function that fires a hook) without calling
+// PyGILState_Ensure/Release, which look the thread state up twice, each
+// time under a lock with the TLS emulation of Python 2.7.
+#ifdef __NT__
+  #define PYW_THREAD_LOCAL __declspec(thread)
+#else
+  #define PYW_THREAD_LOCAL __thread
+#endif
+struct gil_tls_t
+{
+  PyThreadState *tstate;        // NULL if unknown
+  int depth;                    // gil_lock_t that called PyGILState_Ensure()
+  bool permanent;               // 'tstate' lives as long as the thread
+};
+extern PYW_THREAD_LOCAL gil_tls_t gil_tls;
+
 class gil_lock_t
 {
 private:
   PyGILState_STATE state;
+  bool nested;                  // the thread already held the GIL
 public:
   gil_lock_t()
   {
+    PyThreadState *tstate = gil_tls.tstate;
+    nested = tstate != NULL && tstate == _PyThreadState_Current;
+    if ( nested )
+      return;
     state = PyGILState_Ensure();
+    if ( gil_tls.depth++ == 0 && !gil_tls.permanent )
+      gil_tls.tstate = PyThreadState_Get();
   }
 
   ~gil_lock_t()
   {
+    if ( nested )
+      return;
+    if ( --gil_tls.depth == 0 && !gil_tls.permanent )
+      gil_tls.tstate = NULL;
     PyGILState_Release(state);
   }
 };
@@ -369,10 +400,33 @@ bool pywraps_nw_init();
 //---------------------------------------------------------------------------
 bool pywraps_check_autoscripts(char *buf, size_t bufsize);
 
+// How the running scripts check for the script timeout and for Cancel
+#define SCRIPT_BREAK_TRACE     0 // a trace function, called on every interpreter event
+#define SCRIPT_BREAK_WATCHDOG  1 // a watchdog thread, that schedules pending calls
+int set_script_break_mode(int mode);
+PyObject *pywraps_call_with_script_break(PyObject *py_callable, int mode);
+
 // [De]Initializes PyWraps
 bool init_pywraps();
 void deinit_pywraps();
 
+// Starts/stops the native worker threads
+bool pywraps_workers_init();
+void pywraps_workers_term();
+
+// Starts/stops the sampling profiler
+bool pywraps_profiler_start(int interval_ms);
+bool pywraps_profiler_stop(const char *path);
+
+// Compiles through the LRU cache of code objects (new reference)
+PyObject *pywraps_compile_cached(const char *str, int mode);
+void pywraps_code_cache_flush();
+
+// Startup profile (idaapi.get_startup_profile())
+void pywraps_startup_phase(const char *name);
+void pywraps_startup_record(const char *name, uint64 ns);
+void pywraps_startup_dump();
+
 void hexrays_clear_python_cfuncptr_t_references(void);
 
 void free_compiled_form_instances(void);
@@ -7,7 +7,7 @@ print "\n-------- DEPLOY started -----------------------------------------------
 deploys = {
     "idaapi (common functions, notifywhen)" : {
         "tag" : "py_idaapi",
-        "src" : ["py_cvt.hpp", "py_idaapi.hpp", "py_idaapi.py", "py_notifywhen.hpp", "py_notifywhen.py"],
+        "src" : ["py_cvt.hpp", "py_idaapi.hpp", "py_idaapi.py", "py_startup.hpp", "py_notifywhen.hpp", "py_notifywhen.py", "py_workers.hpp", "py_profiler.hpp", "py_hookstats.hpp", "py_codecache.hpp"],
         "tgt" : "../swig/idaapi.i"
         },
 
@@ -61,7 +61,7 @@ deploys = {
 
     "kernwin, choose2, askusingform" : {
         "tag" : "py_kernwin",
-        "src" : ["py_kernwin.hpp","py_kernwin.py","py_choose.hpp","py_choose2.hpp","py_choose2.py","py_askusingform.hpp","py_askusingform.py"],
+        "src" : ["py_kernwin.hpp","py_kernwin.py","py_choose.hpp","py_choose2.hpp","py_choose2.py","py_idlesched.hpp","py_idlesched.py","py_askusingform.hpp","py_askusingform.py"],
         "tgt" : "../swig/kernwin.i"
         },
 
@@ -109,10 +109,28 @@ deploys = {
 
     "bytes" : {
         "tag" : "py_bytes",
-        "src" : ["py_bytes.hpp","py_custdata.py","py_custdata.hpp"],
+        "src" : ["py_bytes.hpp","py_bytes.py","py_custdata.py","py_custdata.hpp"],
         "tgt" : "../swig/bytes.i"
         },
 
+    "funcs" : {
+        "tag" : "py_funcs",
+        "src" : ["py_funcs.hpp"],
+        "tgt" : "../swig/funcs.i"
+        },
+
+    "xref" : {
+        "tag" : "py_xref",
+        "src" : ["py_xref.hpp"],
+        "tgt" : "../swig/xref.i"
+        },
+
+    "search" : {
+        "tag" : "py_search",
+        "src" : ["py_search.hpp"],
+        "tgt" : "../swig/search.i"
+        },
+
     "typeinf" : {
         "tag" : "py_typeinf",
         "src" : ["py_typeinf.hpp","py_typeinf.py"],
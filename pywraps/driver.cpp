@@ -29,6 +29,9 @@
 #include "swig_stub.h"
 #include "py_cvt.hpp"
 #include "py_idaapi.hpp"
+#include "py_startup.hpp"
+#include "py_workers.hpp"
+#include "py_hookstats.hpp"
 #include "py_graph.hpp"
 #include "py_typeinf.hpp"
 #include "py_bytes.hpp"
@@ -85,6 +88,9 @@ void driver_add_methods(PyMethodDef *methods)
 //#include "driver_dbg.cpp"
 //#include "driver_nalt.cpp"
 //#include "driver_cli.cpp"
+//#include "driver_gil.cpp"
+//#include "driver_cvt.cpp"
+//#include "driver_break.cpp"
 
 //--------------------------------------------------------------------------
 //#define DRIVER_FIX
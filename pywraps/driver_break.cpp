@@ -0,0 +1,104 @@
+#include "py_idaapi.hpp"
+
+//-------------------------------------------------------------------------
+// Benchmark of the script break modes (see set_script_break_mode()): the
+// cost of making a running script breakable, with the trace function
+// ('trace', SCRIPT_BREAK_TRACE) and with the watchdog thread ('watchdog',
+// SCRIPT_BREAK_WATCHDOG), compared to no check at all ('none').
+// The callable is run through pywraps_call_with_script_break(), i.e. with
+// the begin_execution()/end_execution() of python.cpp, as a script is.
+// Usage:
+//   print pywraps.break_bench()
+//   print pywraps.break_bench(7, 1, my_function)
+// Arguments: the number of runs (the best time of each mode is kept), the
+// script timeout in seconds (by default, 2; a workload that runs longer
+// than the timeout shows the wait box, and the watchdog then polls every
+// 50ms), and the callable to run (by default, bench_break_workload below).
+// The modes are run interleaved, after one warm-up run of the callable.
+// The result gives the best time of each mode in seconds.
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// CPU-bound loop, and calls: the two kinds of interpreter events
+static const char bench_break_workload[] =
+  "def fib(n):\n"
+  "  return n if n < 2 else fib(n - 1) + fib(n - 2)\n"
+  "def bench_break_workload():\n"
+  "  s = 0\n"
+  "  for i in xrange(5000000):\n"
+  "    s += i & 7\n"
+  "  return s + fib(27)\n";
+
+static const int bench_break_modes[] = { -1, SCRIPT_BREAK_TRACE, SCRIPT_BREAK_WATCHDOG };
+
+//-------------------------------------------------------------------------
+// Seconds, or -1 if the callable failed
+static double bench_break_run(PyObject *py_callable, int mode)
+{
+  uint64 t0 = get_nsec_stamp();
+  newref_t py_res(pywraps_call_with_script_break(py_callable, mode));
+  uint64 t1 = get_nsec_stamp();
+  return py_res == NULL ? -1 : (t1 - t0) / 1e9;
+}
+
+//-------------------------------------------------------------------------
+static PyObject *ex_break_bench(PyObject * /*self*/, PyObject *args)
+{
+  int nruns = 5;
+  int timeout = 2;
+  PyObject *py_callable = NULL;
+  if ( !PyArg_ParseTuple(args, "|iiO", &nruns, &timeout, &py_callable) )
+    return NULL;
+  if ( nruns <= 0 || timeout <= 0 )
+  {
+    PyErr_SetString(PyExc_ValueError, "expected a positive number of runs and timeout");
+    return NULL;
+  }
+
+  ref_t py_fn;
+  if ( py_callable != NULL )
+  {
+    py_fn = borref_t(py_callable);
+  }
+  else
+  {
+    newref_t py_globals(PyDict_New());
+    PyDict_SetItemString(py_globals.o, "__builtins__", PyEval_GetBuiltins());
+    newref_t py_res(PyRun_String(bench_break_workload, Py_file_input, py_globals.o, py_globals.o));
+    if ( py_res == NULL )
+      return NULL;
+    py_fn = borref_t(PyDict_GetItemString(py_globals.o, "bench_break_workload"));
+  }
+
+  // Warm-up, then the modes interleaved so that they see the same noise
+  int old_timeout = set_script_timeout(timeout);
+  double best[qnumber(bench_break_modes)];
+  bool ok = bench_break_run(py_fn.o, -1) >= 0;
+  for ( int i = 0; ok && i < nruns; ++i )
+  {
+    for ( size_t m = 0; ok && m < qnumber(bench_break_modes); ++m )
+    {
+      double t = bench_break_run(py_fn.o, bench_break_modes[m]);
+      ok = t >= 0;
+      if ( i == 0 || t < best[m] )
+        best[m] = t;
+    }
+  }
+  set_script_timeout(old_timeout);
+  if ( !ok )
+    return NULL;
+
+  return Py_BuildValue(
+          "{s:d,s:d,s:d}",
+          "none", best[0],
+          "trace", best[1],
+          "watchdog", best[2]);
+}
+
+//-------------------------------------------------------------------------
+static PyMethodDef py_methods_break[] =
+{
+  {"break_bench",  ex_break_bench, METH_VARARGS, ""},
+  {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+DRIVER_INIT_METHODS(break);
@@ -7,13 +7,24 @@ static PyObject *ex_nextthat(PyObject *self, PyObject *args)
   pyul_t addr, bound;
   if ( !PyArg_ParseTuple(args, PY_FMT64 PY_FMT64 "O", &addr, &bound, &callback) )
     return NULL;
-  return Py_BuildValue("i", py_nextthat(pyul_t(addr), pyul_t(bound), callback));
+  return py_nextthat(ea_t(addr), ea_t(bound), callback);
+}
+
+//--------------------------------------------------------------------------
+static PyObject *ex_nextthat_mask(PyObject *self, PyObject *args)
+{
+  pyul_t addr, bound;
+  unsigned int mask, value;
+  if ( !PyArg_ParseTuple(args, PY_FMT64 PY_FMT64 "II", &addr, &bound, &mask, &value) )
+    return NULL;
+  return Py_BuildValue(PY_FMT64, pyul_t(py_nextthat_mask(ea_t(addr), ea_t(bound), flags_t(mask), flags_t(value))));
 }
 
 //--------------------------------------------------------------------------
 static PyMethodDef py_methods_bytes[] =
 {
   {"nextthat",  ex_nextthat, METH_VARARGS, ""},
+  {"nextthat_mask",  ex_nextthat_mask, METH_VARARGS, ""},
   {NULL, NULL, 0, NULL}
 };
 DRIVER_INIT_METHODS(bytes);
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "py_cvt.hpp"
+
+//-------------------------------------------------------------------------
+// Microbenchmark of the Python -> IDC conversion of lists, tuples and
+// dictionaries (pyvar_to_idcvar()), and of the IDC -> Python conversion
+// of the resulting objects (idcvar_to_pyvar()).
+// Usage:
+//   print pywraps.cvt_bench(range(10000), 100)
+//   print pywraps.cvt_bench(dict((str(i), i) for i in xrange(10000)), 100)
+// The result gives the ns per element with the previous conversion of
+// the sequences and dictionaries ('previous'), with the current one
+// ('current'), and for the conversion back to Python ('to_py').
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// pyvar_to_idcvar() before the fast path, for lists and dictionaries:
+// the attribute name of each element went through a PyInt and
+// PyW_ObjectToString(), and the dictionaries through PyDict_Items()
+static int pyvar_to_idcvar_previous(const ref_t &py_var, idc_value_t *idc_var)
+{
+  if ( PyList_CheckExact(py_var.o) || PyW_IsSequenceType(py_var.o) )
+  {
+    VarObject(idc_var);
+    bool is_seq = !PyList_CheckExact(py_var.o);
+    Py_ssize_t size = is_seq ? PySequence_Size(py_var.o) : PyList_Size(py_var.o);
+    bool ok = true;
+    qstring attr_name;
+    for ( Py_ssize_t i=0; i<size; i++ )
+    {
+      ref_t py_item;
+      if ( is_seq )
+        py_item = newref_t(PySequence_GetItem(py_var.o, i));
+      else
+        py_item = borref_t(PyList_GetItem(py_var.o, i));
+      idc_value_t v;
+      ok = pyvar_to_idcvar(py_item, &v, NULL) >= CIP_OK;
+      if ( ok )
+      {
+        newref_t py_int(PyInt_FromSsize_t(i));
+        ok = PyW_ObjectToString(py_int.o, &attr_name);
+        if ( !ok )
+          break;
+        VarSetAttr(idc_var, attr_name.c_str(), &v);
+      }
+      if ( !ok )
+        break;
+    }
+    return ok ? CIP_OK : CIP_FAILED;
+  }
+  if ( PyDict_Check(py_var.o) )
+  {
+    VarObject(idc_var);
+    newref_t py_items(PyDict_Items(py_var.o));
+    qstring key_name;
+    bool ok = true;
+    Py_ssize_t size = PySequence_Size(py_items.o);
+    for ( Py_ssize_t i=0; i<size; i++ )
+    {
+      PyObject *py_item = PyList_GetItem(py_items.o, i);
+      newref_t key(PySequence_GetItem(py_item, 0));
+      newref_t val(PySequence_GetItem(py_item, 1));
+      PyW_ObjectToString(key.o, &key_name);
+      idc_value_t v;
+      ok = pyvar_to_idcvar(val, &v, NULL) >= CIP_OK;
+      if ( ok )
+        VarSetAttr(idc_var, key_name.c_str(), &v);
+      if ( !ok )
+        break;
+    }
+    return ok ? CIP_OK : CIP_FAILED;
+  }
+  return pyvar_to_idcvar(py_var, idc_var, NULL);
+}
+
+//-------------------------------------------------------------------------
+static int pyvar_to_idcvar_current(const ref_t &py_var, idc_value_t *idc_var)
+{
+  return pyvar_to_idcvar(py_var, idc_var, NULL);
+}
+
+//-------------------------------------------------------------------------
+typedef int cvt_bench_cb_t(const ref_t &py_var, idc_value_t *idc_var);
+
+// ns per element, or -1 if the conversion failed
+static double cvt_bench_run(cvt_bench_cb_t *cb, const ref_t &py_obj, Py_ssize_t nelems, int n)
+{
+  uint64 t0 = get_nsec_stamp();
+  for ( int i = 0; i < n; ++i )
+  {
+    idc_value_t v;
+    if ( cb(py_obj, &v) < CIP_OK )
+      return -1;
+  }
+  return double(get_nsec_stamp() - t0) / n / nelems;
+}
+
+//-------------------------------------------------------------------------
+static double cvt_bench_to_py(const ref_t &py_obj, Py_ssize_t nelems, int n)
+{
+  idc_value_t v;
+  if ( pyvar_to_idcvar(py_obj, &v, NULL) < CIP_OK )
+    return -1;
+  uint64 t0 = get_nsec_stamp();
+  for ( int i = 0; i < n; ++i )
+  {
+    // Convert into a dictionary, as the extlang callers that recycle one
+    ref_t py_res = newref_t(PyDict_New());
+    if ( idcvar_to_pyvar(v, &py_res) < CIP_OK )
+      return -1;
+  }
+  return double(get_nsec_stamp() - t0) / n / nelems;
+}
+
+//-------------------------------------------------------------------------
+static PyObject *ex_cvt_bench(PyObject * /*self*/, PyObject *args)
+{
+  PyObject *py_obj;
+  int n;
+  if ( !PyArg_ParseTuple(args, "Oi", &py_obj, &n) || n <= 0 )
+    return NULL;
+  Py_ssize_t nelems = PyObject_Size(py_obj);
+  if ( nelems <= 0 )
+  {
+    PyErr_SetString(PyExc_ValueError, "expected a non empty sequence or dictionary");
+    return NULL;
+  }
+
+  borref_t py_var(py_obj);
+  return Py_BuildValue(
+          "{s:d,s:d,s:d}",
+          "previous", cvt_bench_run(pyvar_to_idcvar_previous, py_var, nelems, n),
+          "current", cvt_bench_run(pyvar_to_idcvar_current, py_var, nelems, n),
+          "to_py", cvt_bench_to_py(py_var, nelems, n));
+}
+
+//-------------------------------------------------------------------------
+static PyMethodDef py_methods_cvt[] =
+{
+  {"cvt_bench",  ex_cvt_bench, METH_VARARGS, ""},
+  {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+DRIVER_INIT_METHODS(cvt);
@@ -0,0 +1,129 @@
+#include "py_idaapi.hpp"
+
+//-------------------------------------------------------------------------
+// Microbenchmark of the GIL acquisition in the kernel callbacks.
+// Usage:
+//   class H(object):
+//       def byte_patched(self, ea): return 0
+//       def OnGetLine(self, n): return ["0x1000", "name"]
+//   print pywraps.gil_bench(H(), 1000000)
+// For each callback, the result gives the ns/call with the previous
+// gil_lock_t ('ensure') and with the current one ('gil_lock'), when the
+// GIL is already held by the caller ('held': a script calls a function
+// that fires the hook) and when it is not ('free': the kernel fires it).
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// gil_lock_t without the thread-local fast path
+class gil_ensure_t
+{
+  PyGILState_STATE state;
+public:
+  gil_ensure_t() { state = PyGILState_Ensure(); }
+  ~gil_ensure_t() { PyGILState_Release(state); }
+};
+
+//-------------------------------------------------------------------------
+// What IDB_Callback() does for idb_event::byte_patched
+template <class LOCK>
+static void bench_idb_callback(PyObject *self, int i)
+{
+  LOCK lock;
+  newref_t py_result(PyObject_CallMethod(self, (char *)"byte_patched", (char *)PY_FMT64, pyul_t(0x1000 + i)));
+  if ( py_result == NULL )
+    PyErr_Clear();
+}
+
+//-------------------------------------------------------------------------
+// What py_choose2_t::on_get_line() does, for two columns
+template <class LOCK>
+static void bench_on_get_line(PyObject *self, int i)
+{
+  LOCK lock;
+  char line[2][MAXSTR];
+  static py_method_t on_get_line_m("OnGetLine");
+  newref_t py_lineno(PyInt_FromLong(i));
+  newref_t py_list(on_get_line_m.call(self, py_lineno.o, NULL));
+  if ( py_list == NULL )
+  {
+    PyErr_Clear();
+    return;
+  }
+  for ( int c = 0; c < 2; ++c )
+  {
+    borref_t item(PyList_GetItem(py_list.o, c));
+    const char *str = item == NULL ? NULL : PyString_AsString(item.o);
+    if ( str != NULL )
+      qstrncpy(line[c], str, MAXSTR);
+  }
+}
+
+//-------------------------------------------------------------------------
+typedef void bench_cb_t(PyObject *self, int i);
+
+// ns per call. Called with the GIL.
+static double gil_bench_run(bench_cb_t *cb, PyObject *self, int n, bool held)
+{
+  uint64 t0 = get_nsec_stamp();
+  if ( held )
+  {
+    for ( int i = 0; i < n; ++i )
+      cb(self, i);
+  }
+  else
+  {
+    Py_BEGIN_ALLOW_THREADS;
+    for ( int i = 0; i < n; ++i )
+      cb(self, i);
+    Py_END_ALLOW_THREADS;
+  }
+  return double(get_nsec_stamp() - t0) / n;
+}
+
+//-------------------------------------------------------------------------
+static PyObject *ex_gil_bench(PyObject * /*self*/, PyObject *args)
+{
+  PyObject *py_obj;
+  int n;
+  if ( !PyArg_ParseTuple(args, "Oi", &py_obj, &n) || n <= 0 )
+    return NULL;
+
+  // The main thread state, as IDAPython_Init() records it
+  gil_tls_t saved = gil_tls;
+  gil_tls.tstate = PyThreadState_Get();
+  gil_tls.permanent = true;
+
+  struct
+  {
+    const char *name;
+    bench_cb_t *ensure;
+    bench_cb_t *gil_lock;
+  } cbs[] =
+  {
+    { "IDB_Callback", bench_idb_callback<gil_ensure_t>, bench_idb_callback<gil_lock_t> },
+    { "on_get_line",  bench_on_get_line<gil_ensure_t>,  bench_on_get_line<gil_lock_t> },
+  };
+  newref_t py_res(PyDict_New());
+  for ( size_t i = 0; i < qnumber(cbs); ++i )
+  {
+    newref_t py_cb(Py_BuildValue(
+            "{s:d,s:d,s:d,s:d}",
+            "held_ensure", gil_bench_run(cbs[i].ensure, py_obj, n, true),
+            "held_gil_lock", gil_bench_run(cbs[i].gil_lock, py_obj, n, true),
+            "free_ensure", gil_bench_run(cbs[i].ensure, py_obj, n, false),
+            "free_gil_lock", gil_bench_run(cbs[i].gil_lock, py_obj, n, false)));
+    PyDict_SetItemString(py_res.o, cbs[i].name, py_cb.o);
+  }
+
+  gil_tls = saved;
+  py_res.incref();
+  return py_res.o;
+}
+
+//-------------------------------------------------------------------------
+static PyMethodDef py_methods_gil[] =
+{
+  {"gil_bench",  ex_gil_bench, METH_VARARGS, ""},
+  {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+DRIVER_INIT_METHODS(gil);
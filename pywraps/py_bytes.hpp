@@ -11,15 +11,178 @@ static bool idaapi py_testf_cb(flags_t flags, void *ud)
   return result != NULL && PyObject_IsTrue(result.o);
 }
 
+//------------------------------------------------------------------------
+// Compiled flags predicate, used by (next|prev)that() to test the flags
+// without calling back into Python.
+// The nodes are stored in preorder: an AND/OR/NOT node is followed by
+// the nodes of its operands.
+enum flags_pred_op_t
+{
+  FPRED_TEST,   // (flags & mask) == value
+  FPRED_AND,
+  FPRED_OR,
+  FPRED_NOT,
+};
+
+struct flags_pred_node_t
+{
+  flags_pred_op_t op;
+  flags_t mask;
+  flags_t value;
+  int nops;     // number of operands
+  int size;     // number of nodes in this subtree, including this one
+};
+DECLARE_TYPE_AS_MOVABLE(flags_pred_node_t);
+typedef qvector<flags_pred_node_t> flags_pred_t;
+
+//------------------------------------------------------------------------
+static void add_flags_pred_test(flags_pred_t *out, flags_t mask, flags_t value)
+{
+  flags_pred_node_t &t = out->push_back();
+  t.op = FPRED_TEST;
+  t.mask = mask;
+  t.value = value & mask;
+  t.nops = 0;
+  t.size = 1;
+}
+
+//------------------------------------------------------------------------
+static bool flags_pred_eval(const flags_pred_node_t *n, flags_t flags)
+{
+  switch ( n->op )
+  {
+    case FPRED_TEST:
+      return (flags & n->mask) == n->value;
+    case FPRED_NOT:
+      return !flags_pred_eval(n + 1, flags);
+    case FPRED_AND:
+    case FPRED_OR:
+      {
+        bool is_and = n->op == FPRED_AND;
+        const flags_pred_node_t *op = n + 1;
+        for ( int i = 0; i < n->nops; ++i, op += op->size )
+        {
+          if ( flags_pred_eval(op, flags) != is_and )
+            return !is_and;
+        }
+        return is_and;
+      }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------
+static bool idaapi flags_pred_testf(flags_t flags, void *ud)
+{
+  const flags_pred_t &pred = *(const flags_pred_t *)ud;
+  return flags_pred_eval(pred.begin(), flags);
+}
+
+//------------------------------------------------------------------------
+// Compiles a Python predicate specification:
+//   (mask, value)
+//   ("and", spec, spec...)
+//   ("or", spec, spec...)
+//   ("not", spec)
+// Sets a Python exception on failure.
+static bool compile_flags_pred(flags_pred_t *out, PyObject *py_spec)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( !PyTuple_Check(py_spec) && !PyList_Check(py_spec) )
+  {
+    PyErr_SetString(PyExc_TypeError, "A flags predicate must be a tuple or a list");
+    return false;
+  }
+  Py_ssize_t n = PySequence_Size(py_spec);
+  if ( n < 1 )
+  {
+    PyErr_SetString(PyExc_ValueError, "Empty flags predicate");
+    return false;
+  }
+
+  newref_t py_first(PySequence_GetItem(py_spec, 0));
+  if ( py_first == NULL )
+    return false;
+  if ( !PyString_Check(py_first.o) )
+  {
+    uint64 mask, value;
+    newref_t py_value(n == 2 ? PySequence_GetItem(py_spec, 1) : NULL);
+    if ( py_value == NULL
+      || !PyW_GetNumber(py_first.o, &mask)
+      || !PyW_GetNumber(py_value.o, &value) )
+    {
+      PyErr_SetString(PyExc_TypeError, "Expected a (mask, value) pair of numbers");
+      return false;
+    }
+    add_flags_pred_test(out, flags_t(mask), flags_t(value));
+    return true;
+  }
+
+  const char *opname = PyString_AsString(py_first.o);
+  flags_pred_op_t op;
+  if ( streq(opname, "and") )
+    op = FPRED_AND;
+  else if ( streq(opname, "or") )
+    op = FPRED_OR;
+  else if ( streq(opname, "not") && n == 2 )
+    op = FPRED_NOT;
+  else
+  {
+    PyErr_Format(PyExc_ValueError, "Unknown flags predicate operator '%s'", opname);
+    return false;
+  }
+
+  size_t idx = out->size();
+  out->push_back();
+
+  for ( Py_ssize_t i = 1; i < n; ++i )
+  {
+    newref_t py_op(PySequence_GetItem(py_spec, i));
+    if ( py_op == NULL || !compile_flags_pred(out, py_op.o) )
+      return false;
+  }
+  // 'out' may have been reallocated: don't hold a reference across the loop
+  flags_pred_node_t &node = out->at(idx);
+  node.op = op;
+  node.mask = 0;
+  node.value = 0;
+  node.nops = int(n - 1);
+  node.size = int(out->size() - idx);
+  return true;
+}
+
+//------------------------------------------------------------------------
+static ea_t npthat_pred(ea_t ea, ea_t bound, const flags_pred_t &pred, bool next)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  ea_t found;
+  Py_BEGIN_ALLOW_THREADS;
+  found = (next ? nextthat : prevthat)(ea, bound, flags_pred_testf, (void *)&pred);
+  Py_END_ALLOW_THREADS;
+  return found;
+}
+
 //------------------------------------------------------------------------
 // Wraps the (next|prev)that()
-static ea_t py_npthat(ea_t ea, ea_t bound, PyObject *py_callable, bool next)
+// Returns NULL, with the exception set, if 'py_callable' is neither
+// a callable nor a valid flags predicate.
+static PyObject *py_npthat(ea_t ea, ea_t bound, PyObject *py_callable, bool next)
 {
   PYW_GIL_CHECK_LOCKED_SCOPE();
-  if ( !PyCallable_Check(py_callable) )
-    return BADADDR;
+  ea_t found;
+  if ( PyCallable_Check(py_callable) )
+  {
+    found = (next ? nextthat : prevthat)(ea, bound, py_testf_cb, py_callable);
+  }
   else
-    return (next ? nextthat : prevthat)(ea, bound, py_testf_cb, py_callable);
+  {
+    // Not a callable: maybe a flags predicate?
+    flags_pred_t pred;
+    if ( !compile_flags_pred(&pred, py_callable) )
+      return NULL;
+    found = npthat_pred(ea, bound, pred, next);
+  }
+  return Py_BuildValue(PY_FMT64, pyul_t(found));
 }
 
 //---------------------------------------------------------------------------
@@ -42,6 +205,685 @@ static int idaapi py_visit_patched_bytes_cb(
   PyW_ShowCbErr("visit_patched_bytes");
   return (py_result != NULL && PyInt_Check(py_result.o)) ? PyInt_AsLong(py_result.o) : 0;
 }
+
+//------------------------------------------------------------------------
+// Gives access to the raw memory of a Python object supporting either
+// the new-style buffer interface, or the old-style one (array.array in
+// Python 2 only implements the latter).
+struct pyw_buffer_t
+{
+  Py_buffer view;
+  bool has_view;
+  bool is_private;
+  void *ptr;
+  Py_ssize_t size;
+
+  pyw_buffer_t() : has_view(false), is_private(false), ptr(NULL), size(0) {}
+  ~pyw_buffer_t()
+  {
+    if ( has_view )
+      PyBuffer_Release(&view);
+  }
+
+  // Can the memory be accessed with the GIL released?
+  // Only if no other thread can resize or free it: either the object is
+  // locked by a new-style buffer export (bytearray refuses to resize
+  // while exported), or nobody else has a reference to it (an array we
+  // just created). An old-style buffer pointer is only valid as long as
+  // we hold the GIL.
+  bool pinned() const { return has_view || is_private; }
+
+  // Sets a Python exception on failure
+  // 'priv': the object was created by the caller and is not shared
+  bool get(PyObject *py_obj, bool writable, bool priv = false)
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    is_private = priv;
+    if ( PyObject_CheckBuffer(py_obj) )
+    {
+      if ( PyObject_GetBuffer(py_obj, &view, writable ? PyBUF_WRITABLE : PyBUF_SIMPLE) != 0 )
+        return false;
+      has_view = true;
+      ptr = view.buf;
+      size = view.len;
+      return true;
+    }
+    if ( writable )
+      return PyObject_AsWriteBuffer(py_obj, &ptr, &size) == 0;
+    const void *rptr;
+    if ( PyObject_AsReadBuffer(py_obj, &rptr, &size) != 0 )
+      return false;
+    ptr = (void *)rptr;
+    return true;
+  }
+};
+
+//------------------------------------------------------------------------
+// Creates an array.array(typecode) of 'count' zeroed items
+static ref_t pyw_create_array(const char *typecode, Py_ssize_t count)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  ref_t py_arr;
+  ref_t py_mod(PyW_TryImportModule("array"));
+  if ( py_mod == NULL )
+    return py_arr;
+  newref_t py_zero(PyObject_CallMethod(py_mod.o, (char *)"array", (char *)"s[i]", typecode, 0));
+  if ( py_zero != NULL )
+    py_arr = newref_t(PySequence_Repeat(py_zero.o, count));
+  return py_arr;
+}
+
+//------------------------------------------------------------------------
+// Creates an array.array(typecode) holding a copy of 'count' items of
+// 'data'. The items must have the size of the typecode's items.
+static PyObject *pyw_array_from_data(const char *typecode, const void *data, size_t count)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  ref_t py_arr(pyw_create_array(typecode, count));
+  if ( py_arr == NULL )
+    return NULL;
+  pyw_buffer_t buf;
+  if ( !buf.get(py_arr.o, true) )
+    return NULL;
+  if ( buf.size > 0 )
+    memcpy(buf.ptr, data, buf.size);
+  py_arr.incref();
+  return py_arr.o;
+}
+
+//------------------------------------------------------------------------
+// Returns the item size of an array.array, or -1 with a Python exception
+static Py_ssize_t pyw_array_itemsize(PyObject *py_arr)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  newref_t py_size(PyObject_GetAttrString(py_arr, "itemsize"));
+  if ( py_size == NULL )
+    return -1;
+  return PyInt_AsSsize_t(py_size.o);
+}
+
+//------------------------------------------------------------------------
+// Reads bytes like get_many_bytes(), except that the bytes without a value
+// are read with get_byte() instead of failing the whole read.
+// Must be called without the GIL
+static void read_db_bytes(ea_t ea, void *buf, size_t size)
+{
+  if ( !get_many_bytes(ea, buf, ssize_t(size)) )
+  {
+    uchar *p = (uchar *)buf;
+    for ( size_t i = 0; i < size; ++i )
+      p[i] = get_byte(ea + i);
+  }
+}
+
+//------------------------------------------------------------------------
+// A window of database bytes, copied on the main thread so that a worker
+// thread can crunch it (see worker_pool_t)
+struct bytes_snapshot_job_t : public worker_job_t
+{
+  ea_t ea;
+  size_t report_len;            // the bytes after it only overlap the next window
+  bytevec_t bytes;
+};
+
+//------------------------------------------------------------------------
+// Runs a kernel over snapshots of the database bytes, in parallel
+class snapshot_scanner_t
+{
+public:
+  virtual ~snapshot_scanner_t() {}
+  // Creates a job for a window (main thread)
+  virtual bytes_snapshot_job_t *new_job() = 0;
+  // Collects the results of a job (main thread, in address order)
+  virtual void merge(const bytes_snapshot_job_t &job) = 0;
+
+  // Scans [ea1, ea2) in windows of 'window' bytes, each window also
+  // holding the first 'overlap' bytes of the next one.
+  // Must be called without the GIL. Returns false if cancelled.
+  bool scan(ea_t ea1, ea_t ea2, size_t window, size_t overlap)
+  {
+    // Bound the memory used by the snapshots
+    size_t nthreads = worker_pool == NULL ? 0 : worker_pool->size();
+    size_t batch_size = qmax(nthreads, size_t(1)) * 4;
+    worker_jobs_t jobs;
+    bool ok = true;
+    for ( ea_t ea = ea1; ok && ea < ea2; )
+    {
+      bytes_snapshot_job_t *job = new_job();
+      job->ea = ea;
+      job->report_len = size_t(qmin(ea_t(window), ea2 - ea));
+      size_t len = size_t(qmin(ea_t(job->report_len + overlap), ea2 - ea));
+      job->bytes.resize(len);
+      read_db_bytes(ea, job->bytes.begin(), len);
+      jobs.push_back(job);
+      ea += job->report_len;
+      if ( jobs.size() == batch_size || ea >= ea2 )
+      {
+        ok = run_worker_jobs(jobs);
+        for ( size_t i = 0; i < jobs.size(); ++i )
+        {
+          bytes_snapshot_job_t *j = (bytes_snapshot_job_t *)jobs[i];
+          if ( ok )
+            merge(*j);
+          delete j;
+        }
+        jobs.clear();
+      }
+    }
+    return ok;
+  }
+};
+
+//------------------------------------------------------------------------
+// Shannon entropy (in bits per byte) of each block of a window
+struct entropy_job_t : public bytes_snapshot_job_t
+{
+  size_t block_size;
+  qvector<double> entropies;
+
+  virtual void run(const volatile bool *cancelled)
+  {
+    for ( size_t off = 0; off < report_len && !*cancelled; off += block_size )
+    {
+      size_t size = qmin(block_size, report_len - off);
+      size_t counts[256];
+      memset(counts, 0, sizeof(counts));
+      const uchar *p = bytes.begin() + off;
+      for ( size_t i = 0; i < size; ++i )
+        counts[p[i]]++;
+      double e = 0;
+      for ( int c = 0; c < 256; ++c )
+      {
+        if ( counts[c] == 0 )
+          continue;
+        double f = double(counts[c]) / size;
+        e -= f * log(f);
+      }
+      entropies.push_back(e / log(2.0));
+    }
+  }
+};
+
+struct entropy_scanner_t : public snapshot_scanner_t
+{
+  size_t block_size;
+  qvector<double> entropies;
+
+  entropy_scanner_t(size_t _block_size) : block_size(_block_size) {}
+  virtual bytes_snapshot_job_t *new_job()
+  {
+    entropy_job_t *job = new entropy_job_t;
+    job->block_size = block_size;
+    return job;
+  }
+  virtual void merge(const bytes_snapshot_job_t &job)
+  {
+    const qvector<double> &e = ((const entropy_job_t &)job).entropies;
+    for ( size_t i = 0; i < e.size(); ++i )
+      entropies.push_back(e[i]);
+  }
+};
+
+//------------------------------------------------------------------------
+// Tells whether items must be byte-swapped between the database and the
+// host. 'py_big_endian' is None to use the processor endianness.
+static bool must_swap_items(PyObject *py_big_endian)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  bool db_be = py_big_endian == NULL || py_big_endian == Py_None
+             ? inf.mf != 0
+             : PyObject_IsTrue(py_big_endian) == 1;
+  static const uint16 one = 1;
+  bool host_be = *(const uchar *)&one == 0;
+  return db_be != host_be;
+}
+
+//------------------------------------------------------------------------
+// Reverses the byte order of each item of 'buf'
+static void swap_items(void *buf, size_t size, size_t itemsize)
+{
+  if ( itemsize < 2 )
+    return;
+  uchar *p = (uchar *)buf;
+  for ( size_t off = 0; off + itemsize <= size; off += itemsize )
+    for ( size_t i = 0, j = itemsize - 1; i < j; ++i, --j )
+      qswap(p[off + i], p[off + j]);
+}
+
+//------------------------------------------------------------------------
+// A run of consecutive addresses whose (flags & mask) is identical
+struct flags_run_t
+{
+  ea_t start_ea;
+  ea_t end_ea;
+  flags_t flags;
+};
+DECLARE_TYPE_AS_MOVABLE(flags_run_t);
+typedef qvector<flags_run_t> flags_runs_t;
+
+//------------------------------------------------------------------------
+// Must be called without the GIL
+static void collect_flags_runs(flags_runs_t *out, ea_t ea1, ea_t ea2, flags_t mask)
+{
+  // The tail bytes of an item all have the same class bits, but they may
+  // differ in the others (value, FF_REF and the other MS_COMM bits...):
+  // they can be skipped at once only if the mask keeps just the class
+  bool skip_tails = (mask & ~MS_CLS) == 0;
+  ea_t ea = ea1;
+  while ( ea < ea2 )
+  {
+    if ( !isEnabled(ea) )
+    {
+      // Skip the whole gap at once. It is not reported: it ends the
+      // current run, so that the runs on both sides are not merged.
+      ea_t next = nextaddr(ea);
+      if ( next == BADADDR || next <= ea )
+        break;
+      ea = next;
+      continue;
+    }
+
+    flags_t f = getFlags(ea);
+    ea_t next;
+    if ( skip_tails && isTail(f) )
+      next = next_not_tail(ea);
+    else
+      next = ea + 1;
+    if ( next == BADADDR || next > ea2 || next <= ea )
+      next = ea2;
+
+    f &= mask;
+    if ( !out->empty() && out->back().flags == f && out->back().end_ea == ea )
+    {
+      out->back().end_ea = next;
+    }
+    else
+    {
+      flags_run_t &r = out->push_back();
+      r.start_ea = ea;
+      r.end_ea = next;
+      r.flags = f;
+    }
+    ea = next;
+  }
+}
+
+//------------------------------------------------------------------------
+// bytes_view: a read-only, buffer-protocol object over a database range.
+//
+// Indexing and slicing go through a page cache: the range is split in
+// 64KB chunks that are read with get_many_bytes() when they are first
+// touched. At most BYTES_VIEW_MAX_CHUNKS chunks are cached per view, the
+// least recently used one is evicted to make room for a new one. Thus a
+// view over a multi-hundred-MB range only holds a few MB.
+//
+// The buffer protocol needs the whole range in one contiguous block. It
+// is only offered by views of at most BYTES_VIEW_MAX_EXPORT bytes: the
+// first export reads the whole range into 'export_buf', which is then
+// kept (the old-style buffer interface has no release) until the view is
+// destroyed. Larger ranges must be scanned through smaller views.
+//
+// The database is read with the GIL released, into memory that no other
+// thread can see yet: the new chunk (or export buffer) is only published,
+// or copied into the shared one, once we hold the GIL again.
+//
+// All live views are registered in 'py_bytes_views'. While there is at
+// least one of them, we listen to the 'byte_patched' IDB event and update
+// the patched byte in the cached chunks and in the export buffer. Chunks
+// that are not cached will get the new value when they are read.
+#define BYTES_VIEW_CHUNK_SHIFT 16
+#define BYTES_VIEW_CHUNK_SIZE  (1 << BYTES_VIEW_CHUNK_SHIFT)
+#define BYTES_VIEW_MAX_CHUNKS  64
+#define BYTES_VIEW_MAX_EXPORT  (16 * 1024 * 1024)
+
+struct py_bytes_view_t
+{
+  PyObject_HEAD
+  ea_t start_ea;
+  ea_t end_ea;
+  uchar **chunks;     // one entry per chunk: NULL if the chunk is not cached
+  uint64 *stamps;     // one entry per chunk: last use of the cached chunk
+  size_t nchunks;
+  size_t cached[BYTES_VIEW_MAX_CHUNKS]; // the cached chunks
+  size_t ncached;
+  uint64 stamp;
+  uchar *export_buf;  // end_ea - start_ea bytes, once the buffer is exported
+  Py_ssize_t exports; // number of outstanding Py_buffer exports
+};
+
+static PyTypeObject py_bytes_view_type;
+static qvector<py_bytes_view_t *> py_bytes_views;
+
+//------------------------------------------------------------------------
+static Py_ssize_t bytes_view_size(const py_bytes_view_t *v)
+{
+  return Py_ssize_t(v->end_ea - v->start_ea);
+}
+
+//------------------------------------------------------------------------
+static size_t bytes_view_chunk_size(const py_bytes_view_t *v, size_t c)
+{
+  ea_t ea = v->start_ea + (ea_t(c) << BYTES_VIEW_CHUNK_SHIFT);
+  return qmin(size_t(BYTES_VIEW_CHUNK_SIZE), size_t(v->end_ea - ea));
+}
+
+//------------------------------------------------------------------------
+// Drops the least recently used chunk
+static void bytes_view_evict(py_bytes_view_t *v)
+{
+  size_t lru = 0;
+  for ( size_t i = 1; i < v->ncached; ++i )
+    if ( v->stamps[v->cached[i]] < v->stamps[v->cached[lru]] )
+      lru = i;
+  size_t c = v->cached[lru];
+  qfree(v->chunks[c]);
+  v->chunks[c] = NULL;
+  v->cached[lru] = v->cached[--v->ncached];
+}
+
+//------------------------------------------------------------------------
+// Returns the chunk 'c', reading it if it is not cached, or NULL with a
+// Python exception set. The pointer is only valid until the next call:
+// the GIL is released while the chunk is read, and other chunks may be
+// evicted.
+static const uchar *bytes_view_chunk(py_bytes_view_t *v, size_t c)
+{
+  if ( v->chunks[c] == NULL )
+  {
+    size_t size = bytes_view_chunk_size(v, c);
+    uchar *chunk = (uchar *)qalloc(size);
+    if ( chunk == NULL )
+    {
+      PyErr_NoMemory();
+      return NULL;
+    }
+    ea_t ea = v->start_ea + (ea_t(c) << BYTES_VIEW_CHUNK_SHIFT);
+    Py_BEGIN_ALLOW_THREADS;
+    read_db_bytes(ea, chunk, size);
+    Py_END_ALLOW_THREADS;
+    // Another thread may have read it in the meantime
+    if ( v->chunks[c] != NULL )
+    {
+      qfree(chunk);
+    }
+    else
+    {
+      if ( v->ncached == BYTES_VIEW_MAX_CHUNKS )
+        bytes_view_evict(v);
+      v->chunks[c] = chunk;
+      v->cached[v->ncached++] = c;
+    }
+  }
+  v->stamps[c] = ++v->stamp;
+  return v->chunks[c];
+}
+
+//------------------------------------------------------------------------
+// Copies the bytes [off1, off2) of the view to 'out'. On failure, returns
+// false with a Python exception set.
+static bool bytes_view_copy(py_bytes_view_t *v, uchar *out, Py_ssize_t off1, Py_ssize_t off2)
+{
+  while ( off1 < off2 )
+  {
+    size_t c = size_t(off1) >> BYTES_VIEW_CHUNK_SHIFT;
+    const uchar *chunk = bytes_view_chunk(v, c);
+    if ( chunk == NULL )
+      return false;
+    size_t coff = size_t(off1) & (BYTES_VIEW_CHUNK_SIZE - 1);
+    size_t n = qmin(bytes_view_chunk_size(v, c) - coff, size_t(off2 - off1));
+    memcpy(out, chunk + coff, n);
+    out += n;
+    off1 += n;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------
+// Reads the whole range for the buffer protocol. On failure, returns
+// false with a Python exception set.
+static bool bytes_view_fill_export(py_bytes_view_t *v)
+{
+  Py_ssize_t size = bytes_view_size(v);
+  if ( size > BYTES_VIEW_MAX_EXPORT )
+  {
+    PyErr_Format(PyExc_BufferError,
+                 "bytes_view too large for the buffer protocol (%d MB max): use smaller views or slices",
+                 BYTES_VIEW_MAX_EXPORT >> 20);
+    return false;
+  }
+  uchar *buf = (uchar *)qalloc(size);
+  if ( buf == NULL )
+  {
+    PyErr_NoMemory();
+    return false;
+  }
+  ea_t ea = v->start_ea;
+  Py_BEGIN_ALLOW_THREADS;
+  read_db_bytes(ea, buf, size);
+  Py_END_ALLOW_THREADS;
+  if ( v->export_buf == NULL )
+  {
+    v->export_buf = buf;
+  }
+  else
+  {
+    // Someone may be holding a pointer to it: update it in place
+    memcpy(v->export_buf, buf, size);
+    qfree(buf);
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------
+static int idaapi bytes_view_idb_cb(void *, int notification_code, va_list va)
+{
+  if ( notification_code != idb_event::byte_patched )
+    return 0;
+
+  ea_t ea = va_arg(va, ea_t);
+  PYW_GIL_GET;
+  for ( size_t i = 0, n = py_bytes_views.size(); i < n; ++i )
+  {
+    py_bytes_view_t *v = py_bytes_views[i];
+    if ( ea < v->start_ea || ea >= v->end_ea )
+      continue;
+    size_t off = size_t(ea - v->start_ea);
+    uchar *chunk = v->chunks[off >> BYTES_VIEW_CHUNK_SHIFT];
+    if ( chunk == NULL && v->export_buf == NULL )
+      continue;
+    uchar b = get_byte(ea);
+    if ( chunk != NULL )
+      chunk[off & (BYTES_VIEW_CHUNK_SIZE - 1)] = b;
+    if ( v->export_buf != NULL )
+      v->export_buf[off] = b;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------
+static void bytes_view_dealloc(PyObject *self)
+{
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  py_bytes_views.del(v);
+  if ( py_bytes_views.empty() )
+    unhook_from_notification_point(HT_IDB, bytes_view_idb_cb, NULL);
+  while ( v->ncached > 0 )
+    bytes_view_evict(v);
+  qfree(v->chunks);
+  qfree(v->stamps);
+  qfree(v->export_buf);
+  PyObject_Del(self);
+}
+
+//------------------------------------------------------------------------
+static PyObject *bytes_view_repr(PyObject *self)
+{
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  char buf[MAXSTR];
+  qsnprintf(buf, sizeof(buf), "<bytes_view [%a, %a)>", v->start_ea, v->end_ea);
+  return PyString_FromString(buf);
+}
+
+//------------------------------------------------------------------------
+static Py_ssize_t bytes_view_sq_length(PyObject *self)
+{
+  return bytes_view_size((py_bytes_view_t *)self);
+}
+
+//------------------------------------------------------------------------
+static PyObject *bytes_view_sq_item(PyObject *self, Py_ssize_t i)
+{
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  if ( i < 0 || i >= bytes_view_size(v) )
+  {
+    PyErr_SetString(PyExc_IndexError, "bytes_view index out of range");
+    return NULL;
+  }
+  const uchar *chunk = bytes_view_chunk(v, size_t(i) >> BYTES_VIEW_CHUNK_SHIFT);
+  if ( chunk == NULL )
+    return NULL;
+  return PyInt_FromLong(chunk[size_t(i) & (BYTES_VIEW_CHUNK_SIZE - 1)]);
+}
+
+//------------------------------------------------------------------------
+static PyObject *bytes_view_sq_slice(PyObject *self, Py_ssize_t i1, Py_ssize_t i2)
+{
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  Py_ssize_t size = bytes_view_size(v);
+  i1 = qmax(Py_ssize_t(0), qmin(i1, size));
+  i2 = qmax(i1, qmin(i2, size));
+  newref_t py_str(PyString_FromStringAndSize(NULL, i2 - i1));
+  if ( py_str == NULL
+    || !bytes_view_copy(v, (uchar *)PyString_AS_STRING(py_str.o), i1, i2) )
+  {
+    return NULL;
+  }
+  py_str.incref();
+  return py_str.o;
+}
+
+//------------------------------------------------------------------------
+// Old-style (Python 2) buffer interface: used by buffer(), str(), file.write()...
+static Py_ssize_t bytes_view_getreadbuffer(PyObject *self, Py_ssize_t segment, void **ptr)
+{
+  if ( segment != 0 )
+  {
+    PyErr_SetString(PyExc_SystemError, "accessing non-existent bytes_view segment");
+    return -1;
+  }
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  if ( v->export_buf == NULL && !bytes_view_fill_export(v) )
+    return -1;
+  *ptr = v->export_buf;
+  return bytes_view_size(v);
+}
+
+//------------------------------------------------------------------------
+static Py_ssize_t bytes_view_getsegcount(PyObject *self, Py_ssize_t *lenp)
+{
+  if ( lenp != NULL )
+    *lenp = bytes_view_size((py_bytes_view_t *)self);
+  return 1;
+}
+
+//------------------------------------------------------------------------
+static Py_ssize_t bytes_view_getcharbuffer(PyObject *self, Py_ssize_t segment, char **ptr)
+{
+  return bytes_view_getreadbuffer(self, segment, (void **)ptr);
+}
+
+//------------------------------------------------------------------------
+// New-style buffer interface: used by memoryview, struct.unpack_from(), array...
+static int bytes_view_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  if ( v->export_buf == NULL && !bytes_view_fill_export(v) )
+  {
+    view->obj = NULL;
+    return -1;
+  }
+  if ( PyBuffer_FillInfo(view, self, v->export_buf, bytes_view_size(v), 1, flags) != 0 )
+    return -1;
+  ++v->exports;
+  return 0;
+}
+
+//------------------------------------------------------------------------
+static void bytes_view_releasebuffer(PyObject *self, Py_buffer *)
+{
+  --((py_bytes_view_t *)self)->exports;
+}
+
+//------------------------------------------------------------------------
+static PyObject *bytes_view_invalidate(PyObject *self, PyObject *)
+{
+  py_bytes_view_t *v = (py_bytes_view_t *)self;
+  while ( v->ncached > 0 )
+    bytes_view_evict(v);
+  // Someone may be holding a pointer to the export buffer: re-read it
+  if ( v->export_buf != NULL && !bytes_view_fill_export(v) )
+    return NULL;
+  Py_RETURN_NONE;
+}
+
+//------------------------------------------------------------------------
+static PyObject *bytes_view_get_start_ea(PyObject *self, void *)
+{
+  return Py_BuildValue(PY_FMT64, pyul_t(((py_bytes_view_t *)self)->start_ea));
+}
+
+//------------------------------------------------------------------------
+static PyObject *bytes_view_get_end_ea(PyObject *self, void *)
+{
+  return Py_BuildValue(PY_FMT64, pyul_t(((py_bytes_view_t *)self)->end_ea));
+}
+
+//------------------------------------------------------------------------
+static bool init_bytes_view_type()
+{
+  if ( (py_bytes_view_type.tp_flags & Py_TPFLAGS_READY) != 0 )
+    return true;
+
+  static PySequenceMethods seq_methods;
+  seq_methods.sq_length = bytes_view_sq_length;
+  seq_methods.sq_item   = bytes_view_sq_item;
+  seq_methods.sq_slice  = bytes_view_sq_slice;
+
+  static PyBufferProcs buffer_procs;
+  buffer_procs.bf_getreadbuffer = bytes_view_getreadbuffer;
+  buffer_procs.bf_getsegcount   = bytes_view_getsegcount;
+  buffer_procs.bf_getcharbuffer = bytes_view_getcharbuffer;
+  buffer_procs.bf_getbuffer     = bytes_view_getbuffer;
+  buffer_procs.bf_releasebuffer = bytes_view_releasebuffer;
+
+  static PyMethodDef methods[] =
+  {
+    { "invalidate", bytes_view_invalidate, METH_NOARGS, "Discard the cached bytes" },
+    { NULL }
+  };
+
+  static PyGetSetDef getset[] =
+  {
+    { (char *)"start_ea", bytes_view_get_start_ea, NULL, (char *)"First address of the view", NULL },
+    { (char *)"end_ea", bytes_view_get_end_ea, NULL, (char *)"Address past the end of the view", NULL },
+    { NULL }
+  };
+
+  PyTypeObject &t = py_bytes_view_type;
+  Py_REFCNT(&t)     = 1;
+  Py_TYPE(&t)       = &PyType_Type;
+  t.tp_name         = "idaapi.bytes_view";
+  t.tp_basicsize    = sizeof(py_bytes_view_t);
+  t.tp_dealloc      = bytes_view_dealloc;
+  t.tp_repr         = bytes_view_repr;
+  t.tp_as_sequence  = &seq_methods;
+  t.tp_as_buffer    = &buffer_procs;
+  t.tp_flags        = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+  t.tp_doc          = "Read-only buffer over a range of database bytes";
+  t.tp_methods      = methods;
+  t.tp_getset       = getset;
+  return PyType_Ready(&t) == 0;
+}
 //</code(py_bytes)>
 //------------------------------------------------------------------------
 
@@ -86,22 +928,68 @@ def nextthat(ea, maxea, callable):
 
     @param callable: a Python callable with the following prototype:
                      callable(flags). Return True to stop enumeration.
+                     It can also be a flags predicate (see flags_test(),
+                     flags_and(), flags_or() and flags_not()), which is
+                     evaluated natively, without calling back into Python.
     @return: the found address or BADADDR.
+             Raises TypeError or ValueError if 'callable' is neither a
+             callable nor a valid flags predicate.
     """
     pass
 #</pydoc>
 */
-static ea_t py_nextthat(ea_t ea, ea_t maxea, PyObject *callable)
+static PyObject *py_nextthat(ea_t ea, ea_t maxea, PyObject *callable)
 {
   return py_npthat(ea, maxea, callable, true);
 }
 
 //---------------------------------------------------------------------------
-static ea_t py_prevthat(ea_t ea, ea_t minea, PyObject *callable)
+static PyObject *py_prevthat(ea_t ea, ea_t minea, PyObject *callable)
 {
   return py_npthat(ea, minea, callable, false);
 }
 
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def nextthat_mask(ea, maxea, mask, value):
+    """
+    Find next address whose flags satisfy (flags & mask) == value.
+    Start searching from address 'ea'+1 and inspect bytes up to 'maxea'.
+    maxea is not included in the search range.
+    The search is done natively, with the GIL released.
+    @return: the found address or BADADDR.
+    """
+    pass
+#</pydoc>
+*/
+static ea_t py_nextthat_mask(ea_t ea, ea_t maxea, flags_t mask, flags_t value)
+{
+  flags_pred_t pred;
+  add_flags_pred_test(&pred, mask, value);
+  return npthat_pred(ea, maxea, pred, true);
+}
+
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def prevthat_mask(ea, minea, mask, value):
+    """
+    Find previous address whose flags satisfy (flags & mask) == value.
+    Start searching from address 'ea'-1 and inspect bytes down to 'minea'.
+    The search is done natively, with the GIL released.
+    @return: the found address or BADADDR.
+    """
+    pass
+#</pydoc>
+*/
+static ea_t py_prevthat_mask(ea_t ea, ea_t minea, flags_t mask, flags_t value)
+{
+  flags_pred_t pred;
+  add_flags_pred_test(&pred, mask, value);
+  return npthat_pred(ea, minea, pred, false);
+}
+
 //------------------------------------------------------------------------
 /*
 #<pydoc>
@@ -138,6 +1026,362 @@ static PyObject *py_get_many_bytes(ea_t ea, unsigned int size)
   Py_RETURN_NONE;
 }
 
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def read_array(ea, count, typecode = 'B', big_endian = None):
+    """
+    Read an array of numbers from the database in one go.
+    Bytes without a value read as 0xFF, like with get_byte().
+    @param ea: program address
+    @param count: number of items to read
+    @param typecode: array.array typecode of the items (e.g., 'B', 'H', 'I', 'L', 'f', 'd')
+    @param big_endian: byte order of the items in the database.
+                       None to use the processor's byte order (inf.mf)
+    @return: a new array.array
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_read_array(
+        ea_t ea,
+        size_t count,
+        const char *typecode = "B",
+        PyObject *py_big_endian = NULL)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( count > size_t(PY_SSIZE_T_MAX / sizeof(double)) )
+  {
+    PyErr_SetString(PyExc_ValueError, "Invalid item count");
+    return NULL;
+  }
+  ref_t py_arr(pyw_create_array(typecode, count));
+  if ( py_arr == NULL )
+    return NULL;
+  Py_ssize_t itemsize = pyw_array_itemsize(py_arr.o);
+  if ( itemsize <= 0 )
+    return NULL;
+  bool swap = must_swap_items(py_big_endian);
+
+  // The array is not shared yet: it can be filled without the GIL
+  pyw_buffer_t buf;
+  if ( !buf.get(py_arr.o, true, true) )
+    return NULL;
+  Py_BEGIN_ALLOW_THREADS;
+  read_db_bytes(ea, buf.ptr, buf.size);
+  if ( swap )
+    swap_items(buf.ptr, buf.size, itemsize);
+  Py_END_ALLOW_THREADS;
+
+  py_arr.incref();
+  return py_arr.o;
+}
+
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def patch_array(ea, buf, typecode = None, big_endian = None):
+    """
+    Patch the database with an array of numbers in one go.
+    The bytes are patched with a single patch_many_bytes() call, but IDA
+    still sends the 'byte_patched' IDB event once per patched byte (an
+    IDB_Hooks in batch mode gets them coalesced into one range).
+    @param ea: program address
+    @param buf: an array.array, or any object supporting the buffer protocol
+    @param typecode: array.array typecode giving the size of the items.
+                     None to use buf.itemsize (or 1 if buf has no itemsize)
+    @param big_endian: byte order of the items in the database.
+                       None to use the processor's byte order (inf.mf)
+    @return: the patched range, as a tuple (start_ea, end_ea), or None on failure
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_patch_array(
+        ea_t ea,
+        PyObject *py_buf,
+        const char *typecode = NULL,
+        PyObject *py_big_endian = NULL)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  Py_ssize_t itemsize = 1;
+  if ( typecode != NULL )
+  {
+    ref_t py_arr(pyw_create_array(typecode, 0));
+    if ( py_arr == NULL )
+      return NULL;
+    itemsize = pyw_array_itemsize(py_arr.o);
+  }
+  else if ( PyObject_HasAttrString(py_buf, "itemsize") )
+  {
+    itemsize = pyw_array_itemsize(py_buf);
+  }
+  if ( itemsize <= 0 )
+    return NULL;
+  bool swap = must_swap_items(py_big_endian);
+
+  pyw_buffer_t buf;
+  if ( !buf.get(py_buf, false) )
+    return NULL;
+  if ( buf.size % itemsize != 0 )
+  {
+    PyErr_SetString(PyExc_ValueError, "Buffer size is not a multiple of the item size");
+    return NULL;
+  }
+  if ( buf.size == 0 )
+    Py_RETURN_NONE;
+
+  // Don't touch the caller's buffer when swapping, and don't read it
+  // without the GIL if another thread could resize or free it
+  bytevec_t tmp;
+  const void *src = buf.ptr;
+  if ( swap || !buf.pinned() )
+  {
+    tmp.resize(buf.size);
+    memcpy(tmp.begin(), buf.ptr, buf.size);
+    src = tmp.begin();
+  }
+  Py_BEGIN_ALLOW_THREADS;
+  if ( swap )
+    swap_items(tmp.begin(), tmp.size(), itemsize);
+  patch_many_bytes(ea, src, buf.size);
+  Py_END_ALLOW_THREADS;
+  return Py_BuildValue("(" PY_FMT64 PY_FMT64 ")", pyul_t(ea), pyul_t(ea + buf.size));
+}
+
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def bytes_view(ea1, ea2):
+    """
+    Get a read-only view over the database bytes in the range [ea1, ea2).
+    The returned object supports len(), indexing and slicing, which read
+    the database lazily, in 64KB chunks. Only the 64 most recently used
+    chunks (4MB) are kept, thus a view can span a whole image.
+    Views of at most 16MB also support the buffer protocol, so they can
+    be passed to memoryview(), struct.unpack_from(), array, buffer(),
+    str(), etc. The first such use reads the whole range, and keeps it
+    until the view is destroyed. For larger views it raises BufferError:
+    scan them through slices, or through smaller views.
+    Patched bytes (see the 'byte_patched' IDB event) are reflected
+    immediately. Use the view's invalidate() method to discard the cached
+    bytes after other kinds of changes (e.g., debugger memory being
+    refreshed).
+    @param ea1: start address
+    @param ea2: end address (excluded)
+    @return: a bytes_view object
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_bytes_view(ea_t ea1, ea_t ea2)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( ea2 <= ea1 || uint64(ea2 - ea1) > uint64(PY_SSIZE_T_MAX) )
+  {
+    PyErr_SetString(PyExc_ValueError, "Invalid address range");
+    return NULL;
+  }
+  if ( !init_bytes_view_type() )
+    return NULL;
+
+  size_t size = size_t(ea2 - ea1);
+  size_t nchunks = (size + BYTES_VIEW_CHUNK_SIZE - 1) >> BYTES_VIEW_CHUNK_SHIFT;
+  uchar **chunks = (uchar **)qcalloc(nchunks, sizeof(uchar *));
+  uint64 *stamps = (uint64 *)qcalloc(nchunks, sizeof(uint64));
+  py_bytes_view_t *v = chunks == NULL || stamps == NULL
+                     ? NULL
+                     : PyObject_New(py_bytes_view_t, &py_bytes_view_type);
+  if ( v == NULL )
+  {
+    qfree(chunks);
+    qfree(stamps);
+    return PyErr_NoMemory();
+  }
+  v->start_ea = ea1;
+  v->end_ea = ea2;
+  v->chunks = chunks;
+  v->stamps = stamps;
+  v->nchunks = nchunks;
+  v->ncached = 0;
+  v->stamp = 0;
+  v->export_buf = NULL;
+  v->exports = 0;
+
+  if ( py_bytes_views.empty() )
+    hook_to_notification_point(HT_IDB, bytes_view_idb_cb, NULL);
+  py_bytes_views.push_back(v);
+  return (PyObject *)v;
+}
+
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def get_flags_range(ea1, ea2, out = None):
+    """
+    Get the flags of all the addresses in [ea1, ea2) in one call.
+    The database is walked with the GIL released.
+    @param ea1: start address
+    @param ea2: end address (excluded)
+    @param out: None to create a new array, or a writable buffer (for
+                example an array.array('I') or a bytearray) with room
+                for at least (ea2 - ea1) 32-bit flags
+    @return: the new array.array('I') if 'out' was None, the number of
+             flags written otherwise
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_get_flags_range(ea_t ea1, ea_t ea2, PyObject *py_out = NULL)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( ea2 <= ea1 || uint64(ea2 - ea1) > uint64(PY_SSIZE_T_MAX / sizeof(flags_t)) )
+  {
+    PyErr_SetString(PyExc_ValueError, "Invalid address range");
+    return NULL;
+  }
+  Py_ssize_t count = Py_ssize_t(ea2 - ea1);
+  bool want_array = py_out == NULL || py_out == Py_None;
+
+  ref_t py_arr;
+  if ( want_array )
+  {
+    py_arr = pyw_create_array("I", count);
+    if ( py_arr == NULL )
+      return NULL;
+    py_out = py_arr.o;
+  }
+
+  pyw_buffer_t buf;
+  if ( !buf.get(py_out, true, want_array) )
+    return NULL;
+  if ( buf.size < Py_ssize_t(count * sizeof(flags_t)) )
+  {
+    PyErr_SetString(PyExc_ValueError, "Output buffer is too small");
+    return NULL;
+  }
+
+  if ( buf.pinned() )
+  {
+    flags_t *out = (flags_t *)buf.ptr;
+    Py_BEGIN_ALLOW_THREADS;
+    for ( ea_t ea = ea1; ea < ea2; ++ea )
+      *out++ = getFlags(ea);
+    Py_END_ALLOW_THREADS;
+  }
+  else
+  {
+    // Another thread may resize or free 'out' while the GIL is released:
+    // collect the flags in a temporary buffer, and copy them with the GIL
+    qvector<flags_t> tmp;
+    tmp.resize(count);
+    flags_t *p = tmp.begin();
+    Py_BEGIN_ALLOW_THREADS;
+    for ( ea_t ea = ea1; ea < ea2; ++ea )
+      *p++ = getFlags(ea);
+    Py_END_ALLOW_THREADS;
+    if ( !buf.get(py_out, true) )
+      return NULL;
+    if ( buf.size < Py_ssize_t(count * sizeof(flags_t)) )
+    {
+      PyErr_SetString(PyExc_ValueError, "Output buffer is too small");
+      return NULL;
+    }
+    memcpy(buf.ptr, tmp.begin(), count * sizeof(flags_t));
+  }
+
+  if ( want_array )
+  {
+    py_arr.incref();
+    return py_arr.o;
+  }
+  return PyInt_FromSsize_t(count);
+}
+
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def get_flags_runs(ea1, ea2, mask = MS_CLS):
+    """
+    Run-length encode the flags of [ea1, ea2).
+    Consecutive addresses whose (flags & mask) are equal are reported as one
+    run. With the default mask, this classifies the range into
+    code/data/tail/unknown runs. Tail bytes are skipped at once when 'mask'
+    only includes the MS_CLS bits.
+    The addresses that do not belong to the program (gaps between the
+    segments, !isEnabled()) are not reported: no run covers them, and a
+    run never spans a gap. Thus a run with flags 0 is made of unexplored
+    bytes only.
+    @param ea1: start address
+    @param ea2: end address (excluded)
+    @param mask: the flag bits to compare
+    @return: a list of (start_ea, end_ea, flags & mask) tuples
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_get_flags_runs(ea_t ea1, ea_t ea2, flags_t mask = MS_CLS)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  flags_runs_t runs;
+  Py_BEGIN_ALLOW_THREADS;
+  collect_flags_runs(&runs, ea1, ea2, mask);
+  Py_END_ALLOW_THREADS;
+
+  PyObject *py_list = PyList_New(runs.size());
+  if ( py_list == NULL )
+    return NULL;
+  for ( size_t i = 0; i < runs.size(); ++i )
+  {
+    const flags_run_t &r = runs[i];
+    PyList_SET_ITEM(py_list, i, Py_BuildValue("(" PY_FMT64 PY_FMT64 "I)",
+                                              pyul_t(r.start_ea),
+                                              pyul_t(r.end_ea),
+                                              r.flags));
+  }
+  return py_list;
+}
+
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def get_block_entropy(ea1, ea2, block_size = 4096):
+    """
+    Compute the Shannon entropy of each block of [ea1, ea2).
+    The bytes are copied out of the database and the blocks are then
+    processed by the native worker threads (see get_worker_count()).
+    The computation can be cancelled from the wait box, if one is displayed.
+    @param ea1: start address
+    @param ea2: end address (excluded)
+    @param block_size: size of the blocks (the last one may be smaller)
+    @return: an array.array('d') of entropies, in bits per byte (0 to 8)
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_get_block_entropy(ea_t ea1, ea_t ea2, size_t block_size = 4096)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( ea2 <= ea1 || block_size == 0 )
+  {
+    PyErr_SetString(PyExc_ValueError, "Invalid address range or block size");
+    return NULL;
+  }
+  // Windows of about 1MB, made of whole blocks
+  size_t window = qmax(size_t(1 << 20) / block_size, size_t(1)) * block_size;
+  entropy_scanner_t scanner(block_size);
+  bool ok;
+  Py_BEGIN_ALLOW_THREADS;
+  ok = scanner.scan(ea1, ea2, window, 0);
+  Py_END_ALLOW_THREADS;
+  if ( !ok )
+  {
+    PyErr_SetString(PyExc_KeyboardInterrupt, "User interrupted");
+    return NULL;
+  }
+  return pyw_array_from_data("d", scanner.entropies.begin(), scanner.entropies.size());
+}
+
 //---------------------------------------------------------------------------
 /*
 #<pydoc>
@@ -0,0 +1,30 @@
+#<pycode(py_bytes)>
+# -----------------------------------------------------------------------
+# Flags predicates for nextthat()/prevthat()
+#
+# Instead of a callable, nextthat() and prevthat() accept a predicate
+# built with the helpers below. It is compiled and evaluated natively,
+# so no Python code runs for each inspected address.
+#
+# Example: find the next code head that has a name
+#   nextthat(ea, maxea, flags_and(flags_test(MS_CLS, FF_CODE), flags_test(FF_NAME)))
+def flags_test(mask, value = None):
+    """
+    Predicate: (flags & mask) == value
+    If 'value' is omitted, all the bits in 'mask' must be set.
+    """
+    return (mask, mask if value is None else value)
+
+def flags_and(*preds):
+    """Predicate: all of 'preds' are satisfied"""
+    return ("and",) + preds
+
+def flags_or(*preds):
+    """Predicate: any of 'preds' is satisfied"""
+    return ("or",) + preds
+
+def flags_not(pred):
+    """Predicate: 'pred' is not satisfied"""
+    return ("not", pred)
+
+#</pycode(py_bytes)>
@@ -231,7 +231,10 @@ private:
 
     // Call Python
     PYW_GIL_CHECK_LOCKED_SCOPE();
-    pycall_res_t list(PyObject_CallMethod(self, (char *)S_ON_GET_LINE, "i", lineno - 1));
+    hook_timer_t timer("Choose2", S_ON_GET_LINE, self);
+    static py_method_t on_get_line_m(S_ON_GET_LINE);
+    newref_t py_lineno(PyInt_FromLong(lineno - 1));
+    pycall_res_t list(on_get_line_m.call(self, py_lineno.o, NULL));
     if ( list.result == NULL )
       return;
 
@@ -251,7 +254,9 @@ private:
   size_t on_get_size()
   {
     PYW_GIL_GET;
-    pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_GET_SIZE, NULL));
+    hook_timer_t timer("Choose2", S_ON_GET_SIZE, self);
+    static py_method_t on_get_size_m(S_ON_GET_SIZE);
+    pycall_res_t pyres(on_get_size_m.call(self, NULL));
     if ( pyres.result == NULL )
       return 0;
 
@@ -261,12 +266,14 @@ private:
   void on_refreshed()
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_REFRESHED, self);
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_REFRESHED, NULL));
   }
 
   void on_select(const intvec_t &intvec)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_SELECTION_CHANGE, self);
     ref_t py_list(PyW_IntVecToPyList(intvec));
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_SELECTION_CHANGE, "O", py_list.o));
   }
@@ -274,6 +281,7 @@ private:
   void on_close()
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_CLOSE, self);
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_CLOSE, NULL));
 
     // Delete this instance if none modal and not embedded
@@ -284,6 +292,7 @@ private:
   int on_delete_line(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_DELETE_LINE, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -296,6 +305,7 @@ private:
   int on_refresh(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_REFRESH, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -308,12 +318,14 @@ private:
   void on_insert_line()
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_INSERT_LINE, self);
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_INSERT_LINE, NULL));
   }
 
   void on_enter(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_SELECT_LINE, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -325,6 +337,7 @@ private:
   void on_edit_line(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_EDIT_LINE, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -336,6 +349,7 @@ private:
   int on_command(int cmd_id, int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_COMMAND, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -349,19 +363,20 @@ private:
   int on_get_icon(int lineno)
   {
     PYW_GIL_GET;
-    pycall_res_t pyres(
-            PyObject_CallMethod(
-                    self,
-                    (char *)S_ON_GET_ICON,
-                    "i",
-                    lineno - 1));
+    hook_timer_t timer("Choose2", S_ON_GET_ICON, self);
+    static py_method_t on_get_icon_m(S_ON_GET_ICON);
+    newref_t py_lineno(PyInt_FromLong(lineno - 1));
+    pycall_res_t pyres(on_get_icon_m.call(self, py_lineno.o, NULL));
     return PyInt_AsLong(pyres.result.o);
   }
 
   void on_get_line_attr(int lineno, chooser_item_attrs_t *attr)
   {
     PYW_GIL_GET;
-    pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_GET_LINE_ATTR, "i", lineno - 1));
+    hook_timer_t timer("Choose2", S_ON_GET_LINE_ATTR, self);
+    static py_method_t on_get_line_attr_m(S_ON_GET_LINE_ATTR);
+    newref_t py_lineno(PyInt_FromLong(lineno - 1));
+    pycall_res_t pyres(on_get_line_attr_m.call(self, py_lineno.o, NULL));
     if ( pyres.result != NULL )
     {
       if ( PyList_Check(pyres.result.o) )
@@ -93,16 +93,21 @@ private:
     int shift)
   {
     PYW_GIL_GET;
+    static py_method_t on_keydown_m(S_ON_KEYDOWN);
+    newref_t py_line(PyString_FromString(line->c_str()));
+    newref_t py_x(PyInt_FromLong(*p_x));
+    newref_t py_sellen(PyInt_FromLong(*p_sellen));
+    newref_t py_vk_key(PyInt_FromLong(*vk_key & 0xffff));
+    newref_t py_shift(PyInt_FromLong(shift));
     newref_t result(
-            PyObject_CallMethod(
+            on_keydown_m.call(
                     self,
-                    (char *)S_ON_KEYDOWN,
-                    "siiHi",
-                    line->c_str(),
-                    *p_x,
-                    *p_sellen,
-                    *vk_key,
-                    shift));
+                    py_line.o,
+                    py_x.o,
+                    py_sellen.o,
+                    py_vk_key.o,
+                    py_shift.o,
+                    NULL));
 
     bool ok = result != NULL && PyTuple_Check(result.o);
 
@@ -148,15 +153,19 @@ private:
           int x)
   {
     PYW_GIL_GET;
+    static py_method_t on_complete_line_m(S_ON_COMPLETE_LINE);
+    newref_t py_prefix(PyString_FromString(prefix));
+    newref_t py_n(PyInt_FromLong(n));
+    newref_t py_line(PyString_FromString(line));
+    newref_t py_x(PyInt_FromLong(x));
     newref_t result(
-            PyObject_CallMethod(
+            on_complete_line_m.call(
                     self,
-                    (char *)S_ON_COMPLETE_LINE,
-                    "sisi",
-                    prefix,
-                    n,
-                    line,
-                    x));
+                    py_prefix.o,
+                    py_n.o,
+                    py_line.o,
+                    py_x.o,
+                    NULL));
 
     bool ok = result != NULL && PyString_Check(result.o);
     PyW_ShowCbErr(S_ON_COMPLETE_LINE);
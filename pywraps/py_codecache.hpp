@@ -0,0 +1,209 @@
+#ifndef __PYWRAPS_CODECACHE__
+#define __PYWRAPS_CODECACHE__
+
+//------------------------------------------------------------------------
+//<code(py_idaapi)>
+//------------------------------------------------------------------------
+// LRU cache of the code objects compiled from the expressions and
+// statements that IDA passes to Python (extlang calcexpr/run_statements,
+// the CLI): breakpoint conditions, for example, are evaluated over and
+// over again.
+// The cache is bounded both in entries and in source text bytes, and it
+// is protected by the GIL.
+//------------------------------------------------------------------------
+#define CODE_CACHE_MAX_ENTRIES 256
+#define CODE_CACHE_MAX_BYTES   (1024 * 1024)
+
+struct code_cache_key_t
+{
+  int mode;       // Py_eval_input, Py_file_input, ...
+  qstring text;
+
+  bool operator<(const code_cache_key_t &r) const
+  {
+    if ( mode != r.mode )
+      return mode < r.mode;
+    return text < r.text;
+  }
+};
+
+struct code_cache_entry_t
+{
+  PyObject *code;
+  uint64 stamp;   // last use, the key of the entry in 'lru'
+};
+
+typedef std::map<code_cache_key_t, code_cache_entry_t> code_cache_map_t;
+typedef std::map<uint64, code_cache_map_t::iterator> code_cache_lru_t;
+
+struct code_cache_t
+{
+  code_cache_map_t entries;
+  code_cache_lru_t lru;       // least recently used first
+  uint64 stamp;
+  size_t bytes;               // source text in the cache
+  size_t max_entries;
+  size_t max_bytes;
+  uint64 hits;
+  uint64 misses;
+
+  code_cache_t()
+    : stamp(0), bytes(0),
+      max_entries(CODE_CACHE_MAX_ENTRIES), max_bytes(CODE_CACHE_MAX_BYTES),
+      hits(0), misses(0) {}
+
+  void erase(code_cache_map_t::iterator p)
+  {
+    PyObject *code = p->second.code;
+    bytes -= p->first.text.length();
+    lru.erase(p->second.stamp);
+    entries.erase(p);
+    Py_DECREF(code);
+  }
+
+  // Evicts the least recently used entries until 'n' more bytes fit
+  void shrink(size_t n)
+  {
+    while ( !lru.empty() && (entries.size() >= max_entries || bytes + n > max_bytes) )
+      erase(lru.begin()->second);
+  }
+
+  void flush()
+  {
+    while ( !lru.empty() )
+      erase(lru.begin()->second);
+  }
+
+  PyObject *compile(const char *str, int mode);
+};
+static code_cache_t code_cache;
+
+//------------------------------------------------------------------------
+// Returns a new reference to the code object of 'str', compiled in 'mode'.
+// On error, returns NULL with the Python exception set.
+PyObject *code_cache_t::compile(const char *str, int mode)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache_key_t key;
+  key.mode = mode;
+  key.text = str;
+  code_cache_map_t::iterator p = entries.find(key);
+  if ( p != entries.end() )
+  {
+    ++hits;
+    lru.erase(p->second.stamp);
+    p->second.stamp = ++stamp;
+    lru[stamp] = p;
+    Py_INCREF(p->second.code);
+    return p->second.code;
+  }
+
+  ++misses;
+  PyCompilerFlags cf = {0};
+  PyObject *code = Py_CompileStringFlags(str, "<string>", mode, &cf);
+  if ( code == NULL )
+    return NULL;
+
+  // Too large to be cached?
+  size_t len = key.text.length();
+  if ( len > max_bytes || max_entries == 0 )
+    return code;
+
+  shrink(len);
+  code_cache_entry_t &e = entries[key];
+  e.code = code;
+  e.stamp = ++stamp;
+  lru[stamp] = entries.find(key);
+  bytes += len;
+  Py_INCREF(code);
+  return code;
+}
+
+//------------------------------------------------------------------------
+PyObject *pywraps_compile_cached(const char *str, int mode)
+{
+  return code_cache.compile(str, mode);
+}
+
+//------------------------------------------------------------------------
+// Must be called with the GIL, before Py_Finalize()
+void pywraps_code_cache_flush()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache.flush();
+}
+//</code(py_idaapi)>
+
+//------------------------------------------------------------------------
+//<inline(py_idaapi)>
+/*
+#<pydoc>
+def get_code_cache_stats():
+    """
+    Returns the statistics of the cache of the compiled expressions and
+    statements (extlang calcexpr and run_statements, command line), as a
+    dictionary with the following keys:
+      - hits, misses: lookups since the last flush_code_cache()
+      - entries, bytes: number of code objects in the cache, and length
+                        of their source text
+      - max_entries, max_bytes: limits of the cache
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *get_code_cache_stats()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  return Py_BuildValue("{s:K,s:K,s:n,s:n,s:n,s:n}",
+                       "hits", (unsigned PY_LONG_LONG)code_cache.hits,
+                       "misses", (unsigned PY_LONG_LONG)code_cache.misses,
+                       "entries", (Py_ssize_t)code_cache.entries.size(),
+                       "bytes", (Py_ssize_t)code_cache.bytes,
+                       "max_entries", (Py_ssize_t)code_cache.max_entries,
+                       "max_bytes", (Py_ssize_t)code_cache.max_bytes);
+}
+
+/*
+#<pydoc>
+def flush_code_cache():
+    """
+    Empties the cache of the compiled expressions and statements, and
+    resets its statistics.
+    """
+    pass
+#</pydoc>
+*/
+static void flush_code_cache()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache.flush();
+  code_cache.hits = 0;
+  code_cache.misses = 0;
+}
+
+/*
+#<pydoc>
+def set_code_cache_limits(max_entries, max_bytes):
+    """
+    Sets the limits of the cache of the compiled expressions and
+    statements. The least recently used code objects are evicted first.
+    @param max_entries: maximal number of code objects (0 disables the cache)
+    @param max_bytes: maximal total length of their source text
+    """
+    pass
+#</pydoc>
+*/
+static void set_code_cache_limits(size_t max_entries, size_t max_bytes)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache.max_entries = max_entries;
+  code_cache.max_bytes = max_bytes;
+  while ( !code_cache.lru.empty()
+       && (code_cache.entries.size() > max_entries || code_cache.bytes > max_bytes) )
+  {
+    code_cache.erase(code_cache.lru.begin()->second);
+  }
+}
+//</inline(py_idaapi)>
+
+#endif
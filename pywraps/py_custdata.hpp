@@ -44,13 +44,10 @@ class py_custom_data_type_t
     // Returns: 0-no such item can be created/displayed
     // this callback is required only for varsize datatypes
     py_custom_data_type_t *_this = (py_custom_data_type_t *)ud;
-    newref_t py_result(
-            PyObject_CallMethod(
-                    _this->py_self,
-                    (char *)S_CALC_ITEM_SIZE,
-                    PY_FMT64 PY_FMT64,
-                    pyul_t(ea),
-                    pyul_t(maxsize)));
+    static py_method_t calc_item_size_m(S_CALC_ITEM_SIZE);
+    newref_t py_ea(Py_BuildValue(PY_FMT64, pyul_t(ea)));
+    newref_t py_maxsize(Py_BuildValue(PY_FMT64, pyul_t(maxsize)));
+    newref_t py_result(calc_item_size_m.call(_this->py_self, py_ea.o, py_maxsize.o, NULL));
 
     if ( PyW_ShowCbErr(S_CALC_ITEM_SIZE) || py_result == NULL )
       return 0;
@@ -198,14 +195,11 @@ private:
       return false;
 
     py_custom_data_format_t *_this = (py_custom_data_format_t *) ud;
-    newref_t py_result(PyObject_CallMethod(
-                               _this->py_self,
-                               (char *)S_PRINTF,
-                               "O" PY_FMT64 "ii",
-                               py_value.o,
-                               pyul_t(current_ea),
-                               operand_num,
-                               dtid));
+    static py_method_t printf_m(S_PRINTF);
+    newref_t py_ea(Py_BuildValue(PY_FMT64, pyul_t(current_ea)));
+    newref_t py_opnum(PyInt_FromLong(operand_num));
+    newref_t py_dtid(PyInt_FromLong(dtid));
+    newref_t py_result(printf_m.call(_this->py_self, py_value.o, py_ea.o, py_opnum.o, py_dtid.o, NULL));
 
     // Error while calling the function?
     if ( PyW_ShowCbErr(S_PRINTF) || py_result == NULL )
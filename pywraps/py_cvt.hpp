@@ -256,6 +256,24 @@ static error_t idaapi py_idc_opaque_dtor(
   return eOk;
 }
 
+//-------------------------------------------------------------------------
+// Formats the attribute name of the IDC object element 'idx' (its decimal
+// representation, as str(idx)) at the end of 'buf', and returns it.
+// 'buf' must have CVT_INDEX_BUFSIZE bytes.
+#define CVT_INDEX_BUFSIZE 24
+static const char *cvt_index_attr_name(char *buf, Py_ssize_t idx)
+{
+  char *p = buf + CVT_INDEX_BUFSIZE;
+  *--p = '\0';
+  size_t n = size_t(idx);
+  do
+  {
+    *--p = char('0' + n % 10);
+    n /= 10;
+  } while ( n != 0 );
+  return p;
+}
+
 //-------------------------------------------------------------------------
 // Converts a Python variable into an IDC variable
 // This function returns on one CIP_XXXX
@@ -304,37 +322,55 @@ int pyvar_to_idcvar(
     // Create the object
     VarObject(idc_var);
 
-    // Determine list size and type
-    bool is_seq = !PyList_CheckExact(py_var.o);
-    Py_ssize_t size = is_seq ? PySequence_Size(py_var.o) : PyList_Size(py_var.o);
+    // Lists and tuples give their items directly,
+    // the other sequences go through the sequence protocol
+    bool is_list = PyList_CheckExact(py_var.o);
+    bool is_tuple = !is_list && PyTuple_CheckExact(py_var.o);
+    Py_ssize_t size = is_list  ? PyList_GET_SIZE(py_var.o)
+                    : is_tuple ? PyTuple_GET_SIZE(py_var.o)
+                    :            PySequence_Size(py_var.o);
     bool ok = true;
-    qstring attr_name;
+    char buf[CVT_INDEX_BUFSIZE];
 
     // Convert each item
     for ( Py_ssize_t i=0; i<size; i++ )
     {
-      // Get the item
+      // Get the item (converting an item may run Python code
+      // that changes the list: hold a reference to it)
       ref_t py_item;
-      if ( is_seq )
-        py_item = newref_t(PySequence_GetItem(py_var.o, i));
+      if ( is_list )
+      {
+        py_item = borref_t(PyList_GET_ITEM(py_var.o, i));
+      }
+      else if ( is_tuple )
+      {
+        py_item = borref_t(PyTuple_GET_ITEM(py_var.o, i));
+      }
       else
-        py_item = borref_t(PyList_GetItem(py_var.o, i));
+      {
+        py_item = newref_t(PySequence_GetItem(py_var.o, i));
+        if ( py_item == NULL )
+        {
+          ok = false;
+          break;
+        }
+      }
 
       // Convert the item into an IDC variable
       idc_value_t v;
       ok = pyvar_to_idcvar(py_item, &v, gvar_sn) >= CIP_OK;
-      if ( ok )
-      {
-        // Form the attribute name
-        newref_t py_int(PyInt_FromSsize_t(i));
-        ok = PyW_ObjectToString(py_int.o, &attr_name);
-        if ( !ok )
-          break;
-        // Store the attribute
-        VarSetAttr(idc_var, attr_name.c_str(), &v);
-      }
       if ( !ok )
         break;
+      // Fail if the list changed, as for the dictionaries below
+      if ( is_list && PyList_GET_SIZE(py_var.o) != size )
+      {
+        PyErr_SetString(PyExc_RuntimeError, "list changed size during conversion");
+        ok = false;
+        break;
+      }
+
+      // Store the attribute, named after the index
+      VarSetAttr(idc_var, cvt_index_attr_name(buf, i), &v);
     }
     return ok ? CIP_OK : CIP_FAILED;
   }
@@ -344,35 +380,54 @@ int pyvar_to_idcvar(
     // Create an empty IDC object
     VarObject(idc_var);
 
-    // Get the dict.items() list
-    newref_t py_items(PyDict_Items(py_var.o));
-
-    // Get the size of the list
-    qstring key_name;
+    qstring key_str;
+    char buf[CVT_INDEX_BUFSIZE];
     bool ok = true;
-    Py_ssize_t size = PySequence_Size(py_items.o);
-    for ( Py_ssize_t i=0; i<size; i++ )
+    // Converting a key or a value may run Python code that changes the
+    // dictionary, and PyDict_Next() would then skip or repeat entries:
+    // fail in that case, as Python does when iterating over a dictionary
+    PyDictObject *py_dict = (PyDictObject *)py_var.o;
+    Py_ssize_t dict_size = PyDict_Size(py_var.o);
+    Py_ssize_t dict_fill = py_dict->ma_fill;
+    Py_ssize_t pos = 0;
+    PyObject *key, *val;
+    while ( PyDict_Next(py_var.o, &pos, &key, &val) )
     {
-      // Get item[i] -> (key, value)
-      PyObject *py_item = PyList_GetItem(py_items.o, i);
-
-      // Extract key/value
-      newref_t key(PySequence_GetItem(py_item, 0));
-      newref_t val(PySequence_GetItem(py_item, 1));
+      // Hold references to the key and value, in case the dictionary
+      // drops them while they are converted
+      borref_t py_key(key);
+      borref_t py_val(val);
 
       // Get key's string representation
-      PyW_ObjectToString(key.o, &key_name);
+      const char *key_name;
+      if ( PyString_CheckExact(key) )
+      {
+        key_name = PyString_AS_STRING(key);
+      }
+      else if ( PyInt_CheckExact(key) && PyInt_AS_LONG(key) >= 0 )
+      {
+        key_name = cvt_index_attr_name(buf, PyInt_AS_LONG(key));
+      }
+      else
+      {
+        PyW_ObjectToString(key, &key_str);
+        key_name = key_str.c_str();
+      }
 
       // Convert the attribute into an IDC value
       idc_value_t v;
-      ok = pyvar_to_idcvar(val, &v, gvar_sn) >= CIP_OK;
-      if ( ok )
-      {
-        // Store the attribute
-        VarSetAttr(idc_var, key_name.c_str(), &v);
-      }
+      ok = pyvar_to_idcvar(py_val, &v, gvar_sn) >= CIP_OK;
       if ( !ok )
         break;
+      if ( PyDict_Size(py_var.o) != dict_size || py_dict->ma_fill != dict_fill )
+      {
+        PyErr_SetString(PyExc_RuntimeError, "dictionary changed size during conversion");
+        ok = false;
+        break;
+      }
+
+      // Store the attribute
+      VarSetAttr(idc_var, key_name, &v);
     }
     return ok ? CIP_OK : CIP_FAILED;
   }
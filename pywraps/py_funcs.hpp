@@ -0,0 +1,236 @@
+#ifndef __PY_IDA_FUNCS__
+#define __PY_IDA_FUNCS__
+
+//-------------------------------------------------------------------------
+//<code(py_funcs)>
+//-------------------------------------------------------------------------
+// Returns the array.array typecode whose items have the size of an ea_t,
+// or NULL if there is none (e.g., 64-bit addresses on Windows: Python 2's
+// array module has no 'Q' typecode)
+static const char *ea_array_typecode()
+{
+  if ( sizeof(ea_t) == sizeof(unsigned int) )
+    return "I";
+  if ( sizeof(ea_t) == sizeof(unsigned long) )
+    return "L";
+  return NULL;
+}
+
+//-------------------------------------------------------------------------
+// Converts a vector of addresses to an array.array, or to a list if no
+// array typecode matches the ea_t size
+static PyObject *eavec_to_pyarray(const eavec_t &eas)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  const char *typecode = ea_array_typecode();
+  if ( typecode == NULL )
+  {
+    PyObject *py_list = PyList_New(eas.size());
+    if ( py_list == NULL )
+      return NULL;
+    for ( size_t i = 0; i < eas.size(); ++i )
+      PyList_SET_ITEM(py_list, i, Py_BuildValue(PY_FMT64, pyul_t(eas[i])));
+    return py_list;
+  }
+
+  return pyw_array_from_data(typecode, eas.begin(), eas.size());
+}
+//</code(py_funcs)>
+
+//-------------------------------------------------------------------------
+//<inline(py_funcs)>
+#define EABI_HEADS      0 // item heads in [start, end)
+#define EABI_FUNCTIONS  1 // function entry points in [start, end)
+#define EABI_FUNC_ITEMS 2 // code items of the function at 'start'
+#define EABI_CHUNKS     3 // chunks of the function at 'start' (start/end pairs)
+
+/*
+#<pydoc>
+class ea_batch_iterator_t(object):
+    """
+    Walks the database natively and hands the addresses it finds to Python
+    in batches, instead of one SWIG call per step.
+    It is the engine behind idautils.Heads(), Functions(), FuncItems() and
+    Chunks().
+    """
+    def __init__(self, kind, start, end = BADADDR, batch_size = 1024):
+        """
+        @param kind: one of EABI_HEADS, EABI_FUNCTIONS, EABI_FUNC_ITEMS, EABI_CHUNKS
+        @param start: start address (or function address for EABI_FUNC_ITEMS and EABI_CHUNKS)
+        @param end: end address (only used by EABI_HEADS and EABI_FUNCTIONS)
+        @param batch_size: maximal number of addresses returned by next_batch()
+        """
+        pass
+
+    def next_batch(self):
+        """
+        Returns the next list of addresses, or None when the iteration is over.
+        For EABI_CHUNKS, the list holds consecutive (start_ea, end_ea) pairs.
+        """
+        pass
+
+    def to_array(self):
+        """
+        Returns all the remaining addresses as one array.array ('I' or 'L',
+        depending on the size of ea_t). If Python has no array typecode
+        matching the size of ea_t, a list is returned instead.
+        """
+        pass
+#</pydoc>
+*/
+class ea_batch_iterator_t
+{
+  int kind;
+  ea_t cur;
+  ea_t end;
+  bool started;
+  bool done;
+  size_t batch_size;
+  eavec_t buf;
+  func_item_iterator_t fii;
+  func_tail_iterator_t fti;
+
+  //-------------------------------------------------------------------------
+  void start()
+  {
+    started = true;
+    switch ( kind )
+    {
+      case EABI_HEADS:
+        if ( cur < end && !isHead(getFlags(cur)) )
+          cur = next_head(cur, end);
+        break;
+
+      case EABI_FUNCTIONS:
+        {
+          // find the first function head chunk in the range
+          func_t *chunk = get_fchunk(cur);
+          if ( chunk == NULL )
+            chunk = get_next_fchunk(cur);
+          while ( chunk != NULL && chunk->startEA < end && (chunk->flags & FUNC_TAIL) != 0 )
+            chunk = get_next_fchunk(chunk->startEA);
+          cur = chunk == NULL ? BADADDR : chunk->startEA;
+        }
+        break;
+
+      case EABI_FUNC_ITEMS:
+        {
+          func_t *pfn = get_func(cur);
+          done = pfn == NULL || !fii.set(pfn);
+        }
+        break;
+
+      case EABI_CHUNKS:
+        {
+          func_t *pfn = get_func(cur);
+          done = pfn == NULL || !fti.set(pfn) || !fti.main();
+        }
+        break;
+
+      default:
+        done = true;
+        break;
+    }
+  }
+
+  //-------------------------------------------------------------------------
+  // Fills 'buf' with at most 'max' addresses.
+  // Only calls the kernel: it must be called without the GIL.
+  void fetch(size_t max)
+  {
+    buf.qclear();
+    if ( !started )
+      start();
+    if ( done )
+      return;
+
+    switch ( kind )
+    {
+      case EABI_HEADS:
+        while ( cur < end && buf.size() < max )
+        {
+          buf.push_back(cur);
+          cur = next_head(cur, end);
+        }
+        done = cur >= end;
+        break;
+
+      case EABI_FUNCTIONS:
+        while ( cur < end && buf.size() < max )
+        {
+          buf.push_back(cur);
+          func_t *pfn = get_next_func(cur);
+          cur = pfn == NULL ? BADADDR : pfn->startEA;
+        }
+        done = cur >= end;
+        break;
+
+      case EABI_FUNC_ITEMS:
+        while ( buf.size() < max )
+        {
+          buf.push_back(fii.current());
+          if ( !fii.next_code() )
+          {
+            done = true;
+            break;
+          }
+        }
+        break;
+
+      case EABI_CHUNKS:
+        while ( buf.size() + 2 <= max )
+        {
+          const area_t &chunk = fti.chunk();
+          buf.push_back(chunk.startEA);
+          buf.push_back(chunk.endEA);
+          if ( !fti.next() )
+          {
+            done = true;
+            break;
+          }
+        }
+        break;
+    }
+  }
+
+public:
+  //-------------------------------------------------------------------------
+  ea_batch_iterator_t(int _kind, ea_t _start, ea_t _end = BADADDR, size_t _batch_size = 1024)
+    : kind(_kind), cur(_start), end(_end), started(false), done(false)
+  {
+    // room for at least one chunk (start/end pair)
+    batch_size = qmax(_batch_size, size_t(2));
+    buf.reserve(batch_size);
+  }
+
+  //-------------------------------------------------------------------------
+  PyObject *next_batch()
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    Py_BEGIN_ALLOW_THREADS;
+    fetch(batch_size);
+    Py_END_ALLOW_THREADS;
+    if ( buf.empty() )
+      Py_RETURN_NONE;
+
+    PyObject *py_list = PyList_New(buf.size());
+    if ( py_list == NULL )
+      return NULL;
+    for ( size_t i = 0; i < buf.size(); ++i )
+      PyList_SET_ITEM(py_list, i, Py_BuildValue(PY_FMT64, pyul_t(buf[i])));
+    return py_list;
+  }
+
+  //-------------------------------------------------------------------------
+  PyObject *to_array()
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    Py_BEGIN_ALLOW_THREADS;
+    fetch(size_t(-1));
+    Py_END_ALLOW_THREADS;
+    return eavec_to_pyarray(buf);
+  }
+};
+//</inline(py_funcs)>
+
+#endif
@@ -126,7 +126,9 @@ private:
   {
     QASSERT(30453, py_customidamemo_t::lookup_info.find_by_py_view(NULL, NULL, (py_graph_t *) obj));
     PYW_GIL_GET;
-    return ((py_graph_t *)obj)->gr_callback(code, va);
+    py_graph_t *_this = (py_graph_t *)obj;
+    hook_timer_t timer("GraphViewer", code, _this->self.o);
+    return _this->gr_callback(code, va);
   }
 
   static bool idaapi s_menucb(void *ud)
@@ -573,7 +575,9 @@ bool py_graph_t::on_user_text(mutable_graph_t * /*g*/, int node, const char **st
 
   // Not cached, call Python
   PYW_GIL_CHECK_LOCKED_SCOPE();
-  newref_t result(PyObject_CallMethod(self.o, (char *)S_ON_GETTEXT, "i", node));
+  static py_method_t on_gettext_m(S_ON_GETTEXT);
+  newref_t py_node(PyInt_FromLong(node));
+  newref_t result(on_gettext_m.call(self.o, py_node.o, NULL));
   PyW_ShowCbErr(S_ON_GETTEXT);
   if ( result == NULL )
     return false;
@@ -621,7 +625,9 @@ int py_graph_t::on_user_hint(mutable_graph_t *, int mousenode, int /*mouseedge_s
     return 0;
 
   PYW_GIL_CHECK_LOCKED_SCOPE();
-  newref_t result(PyObject_CallMethod(self.o, (char *)S_ON_HINT, "i", mousenode));
+  static py_method_t on_hint_m(S_ON_HINT);
+  newref_t py_node(PyInt_FromLong(mousenode));
+  newref_t result(on_hint_m.call(self.o, py_node.o, NULL));
   PyW_ShowCbErr(S_ON_HINT);
   bool ok = result != NULL && PyString_Check(result.o);
   if ( ok )
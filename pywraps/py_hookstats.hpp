@@ -0,0 +1,222 @@
+#ifndef __PYWRAPS_HOOKSTATS__
+#define __PYWRAPS_HOOKSTATS__
+
+//------------------------------------------------------------------------
+//<code(py_idaapi)>
+//------------------------------------------------------------------------
+// Latency statistics of the calls from the kernel into Python hooks.
+// They are collected per (hook class, event, Python class), and only
+// when enabled: a disabled hook_timer_t costs a single test.
+//------------------------------------------------------------------------
+#define HOOK_STATS_NBUCKETS 24 // bucket 0: < 1us; bucket i: [2^(i-1), 2^i) us; the last one is open
+
+struct hook_stat_key_t
+{
+  const char *hook;     // C++ dispatcher class ("IDB_Hooks", ...)
+  const char *event;    // event name, or NULL if 'code' is used
+  int code;             // event code
+  qstring pyclass;      // Python class of the hook object
+
+  bool operator<(const hook_stat_key_t &r) const
+  {
+    int c = strcmp(hook, r.hook);
+    if ( c != 0 )
+      return c < 0;
+    c = strcmp(event != NULL ? event : "", r.event != NULL ? r.event : "");
+    if ( c != 0 )
+      return c < 0;
+    if ( code != r.code )
+      return code < r.code;
+    return pyclass < r.pyclass;
+  }
+};
+
+struct hook_stat_t
+{
+  uint64 count;
+  uint64 total_ns;
+  uint64 max_ns;
+  uint64 buckets[HOOK_STATS_NBUCKETS];
+  hook_stat_t() { memset(this, 0, sizeof(*this)); }
+};
+
+typedef std::map<hook_stat_key_t, hook_stat_t> hook_stats_t;
+static hook_stats_t hook_stats;
+static bool hook_stats_enabled = false;
+
+//------------------------------------------------------------------------
+// Must be called with the GIL (which also protects 'hook_stats')
+static void record_hook_stat(
+        const char *hook,
+        const char *event,
+        int code,
+        PyTypeObject *pytype,
+        uint64 ns)
+{
+  hook_stat_key_t key;
+  key.hook = hook;
+  key.event = event;
+  key.code = event != NULL ? 0 : code;
+  key.pyclass = pytype != NULL ? pytype->tp_name : "?";
+  hook_stat_t &st = hook_stats[key];
+  ++st.count;
+  st.total_ns += ns;
+  if ( ns > st.max_ns )
+    st.max_ns = ns;
+  int b = 0;
+  for ( uint64 us = ns / 1000; us != 0 && b < HOOK_STATS_NBUCKETS - 1; us >>= 1 )
+    ++b;
+  ++st.buckets[b];
+}
+
+//------------------------------------------------------------------------
+// Python object of a hook: either the object itself, or the Python side
+// of a SWIG director
+static PyObject *hook_stats_self(PyObject *self)
+{
+  return self;
+}
+
+template <class T>
+static PyObject *hook_stats_self(T *proxy)
+{
+  return get_director_self(proxy);
+}
+
+//------------------------------------------------------------------------
+// Times the call into Python for the duration of its scope.
+// Must be declared after PYW_GIL_GET, so that it records with the GIL.
+class hook_timer_t
+{
+  const char *hook;
+  const char *event;
+  int code;
+  PyTypeObject *pytype;
+  uint64 t0;
+
+  void init(PyObject *self)
+  {
+    // Keep the type alive: the object may be gone by the end of the scope
+    // (e.g., a chooser deleted in its OnClose)
+    if ( self != NULL )
+    {
+      pytype = Py_TYPE(self);
+      Py_INCREF(pytype);
+    }
+    t0 = get_nsec_stamp();
+  }
+
+public:
+  template <class T>
+  hook_timer_t(const char *_hook, int _code, T *obj)
+    : hook(_hook), event(NULL), code(_code), pytype(NULL), t0(0)
+  {
+    if ( hook_stats_enabled )
+      init(hook_stats_self(obj));
+  }
+
+  template <class T>
+  hook_timer_t(const char *_hook, const char *_event, T *obj)
+    : hook(_hook), event(_event), code(0), pytype(NULL), t0(0)
+  {
+    if ( hook_stats_enabled )
+      init(hook_stats_self(obj));
+  }
+
+  ~hook_timer_t()
+  {
+    if ( t0 == 0 )
+      return;
+    record_hook_stat(hook, event, code, pytype, get_nsec_stamp() - t0);
+    Py_XDECREF(pytype);
+  }
+};
+//</code(py_idaapi)>
+
+//------------------------------------------------------------------------
+//<inline(py_idaapi)>
+/*
+#<pydoc>
+def enable_hook_stats(enable):
+    """
+    Enables or disables the collection of latency statistics for the calls
+    from IDA into Python hooks (IDB_Hooks, IDP_Hooks, DBG_Hooks, UI_Hooks,
+    Choose2 and GraphViewer callbacks).
+    @param enable: True to collect the statistics
+    @return: the previous state
+    """
+    pass
+#</pydoc>
+*/
+static bool enable_hook_stats(bool enable)
+{
+  bool old = hook_stats_enabled;
+  hook_stats_enabled = enable;
+  return old;
+}
+
+/*
+#<pydoc>
+def reset_hook_stats():
+    """
+    Forgets the statistics collected so far.
+    """
+    pass
+#</pydoc>
+*/
+static void reset_hook_stats()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  hook_stats.clear();
+}
+
+/*
+#<pydoc>
+def get_hook_stats():
+    """
+    Returns the statistics collected since the last reset_hook_stats().
+    @return: a dictionary {(hook, event, pyclass): stats}, where:
+             - hook is the name of the hook class ("IDB_Hooks", ...)
+             - event is the notification code, or the method name for
+               the callbacks that have no code (Choose2)
+             - pyclass is the name of the Python class of the hook object
+             - stats is a dictionary with the 'count', 'total_ns' and
+               'max_ns' keys, and 'buckets': a list of counts, where
+               buckets[0] counts the calls faster than 1us and buckets[i]
+               the calls in [2**(i-1), 2**i) us (the last one is open).
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *get_hook_stats()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  newref_t py_dict(PyDict_New());
+  if ( py_dict == NULL )
+    return NULL;
+  for ( hook_stats_t::const_iterator p = hook_stats.begin(); p != hook_stats.end(); ++p )
+  {
+    const hook_stat_key_t &k = p->first;
+    const hook_stat_t &st = p->second;
+    newref_t py_buckets(PyList_New(HOOK_STATS_NBUCKETS));
+    if ( py_buckets == NULL )
+      return NULL;
+    for ( int i = 0; i < HOOK_STATS_NBUCKETS; ++i )
+      PyList_SET_ITEM(py_buckets.o, i, PyLong_FromUnsignedLongLong(st.buckets[i]));
+    newref_t py_key(k.event != NULL
+                  ? Py_BuildValue("(sss)", k.hook, k.event, k.pyclass.c_str())
+                  : Py_BuildValue("(sis)", k.hook, k.code, k.pyclass.c_str()));
+    newref_t py_st(Py_BuildValue("{s:K,s:K,s:K,s:O}",
+                                 "count", (unsigned PY_LONG_LONG)st.count,
+                                 "total_ns", (unsigned PY_LONG_LONG)st.total_ns,
+                                 "max_ns", (unsigned PY_LONG_LONG)st.max_ns,
+                                 "buckets", py_buckets.o));
+    if ( py_key == NULL || py_st == NULL || PyDict_SetItem(py_dict.o, py_key.o, py_st.o) != 0 )
+      return NULL;
+  }
+  py_dict.incref();
+  return py_dict.o;
+}
+//</inline(py_idaapi)>
+
+#endif
@@ -82,6 +82,9 @@ static const char S_PY_IDAAPI_MODNAME[]      = S_IDAAPI_MODNAME;
 static ref_t py_cvt_helper_module;
 static bool pywraps_initialized = false;
 
+// See gil_lock_t
+PYW_THREAD_LOCAL gil_tls_t gil_tls;
+
 //---------------------------------------------------------------------------
 // Context structure used by add|del_menu_item()
 struct py_add_del_menu_item_ctx
@@ -106,6 +109,164 @@ struct py_timer_ctx_t
   PyObject *pycallback;
 };
 
+//---------------------------------------------------------------------------
+// An event dispatched by a hook class (IDB_Hooks, IDP_Hooks), and the
+// Python method that handles it
+struct hook_event_t
+{
+  int code;             // notification code
+  const char *method;   // name of the method
+  int defret;           // what the method of the base class returns
+};
+
+//------------------------------------------------------------------------
+static int find_hook_event(const hook_event_t *events, size_t nevents, int code)
+{
+  for ( size_t i = 0; i < nevents; ++i )
+    if ( events[i].code == code )
+      return int(i);
+  return -1;
+}
+
+//------------------------------------------------------------------------
+// Python side of a SWIG director, or NULL if 'obj' is not a director
+// (i.e., it was created from the SWIG proxy class itself)
+template <class T>
+static PyObject *get_director_self(T *obj)
+{
+  Swig::Director *d = dynamic_cast<Swig::Director *>(obj);
+  return d == NULL ? NULL : d->swig_get_self();
+}
+
+//------------------------------------------------------------------------
+// Returns the bitmask of the events (at most 64) whose method is defined
+// by the Python object 'self' itself, or by a class that comes before the
+// 'base_clsname' SWIG proxy class in its MRO.
+static uint64 get_overridden_events(
+        PyObject *self,
+        const char *base_clsname,
+        const hook_event_t *events,
+        size_t nevents)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( self == NULL )
+    return 0; // not subclassed: nothing to dispatch
+
+  ref_t py_base(PyW_TryGetAttrString(py_cvt_helper_module.o, base_clsname));
+  PyObject *mro = Py_TYPE(self)->tp_mro;
+  if ( py_base == NULL || mro == NULL || !PyTuple_Check(mro) )
+    return ~uint64(0); // can't tell: dispatch everything
+
+  PyObject **dictptr = _PyObject_GetDictPtr(self);
+  uint64 mask = 0;
+  for ( size_t i = 0; i < nevents && i < 64; ++i )
+  {
+    const char *method = events[i].method;
+    bool found = dictptr != NULL
+              && *dictptr != NULL
+              && PyDict_GetItemString(*dictptr, method) != NULL;
+    for ( Py_ssize_t j = 0; !found && j < PyTuple_GET_SIZE(mro); ++j )
+    {
+      PyObject *cls = PyTuple_GET_ITEM(mro, j);
+      if ( cls == py_base.o )
+        break;
+      PyObject *dict = NULL;
+      if ( PyType_Check(cls) )
+        dict = ((PyTypeObject *)cls)->tp_dict;
+      else if ( PyClass_Check(cls) )
+        dict = ((PyClassObject *)cls)->cl_dict;
+      found = dict != NULL && PyDict_GetItemString(dict, method) != NULL;
+    }
+    if ( found )
+      mask |= uint64(1) << i;
+  }
+  return mask;
+}
+
+//------------------------------------------------------------------------
+// A method that is called back often (Choose2.OnGetLine, ...).
+// The name is interned once, and call() resolves it through the type
+// attribute cache (that Python invalidates whenever a class attribute is
+// assigned) and the instance dictionary. A plain function is then called
+// directly: no lookup by name, no bound method, no format string parsing.
+// No bound method is kept around, as it would keep the object alive.
+class py_method_t
+{
+  const char *name;
+  PyObject *py_name;    // interned; never released
+
+public:
+  explicit py_method_t(const char *_name) : name(_name), py_name(NULL) {}
+
+  //------------------------------------------------------------------------
+  // Calls self.<name>(...) with a NULL-terminated list of arguments.
+  // Returns a new reference, or NULL if an exception was raised.
+  PyObject *call(PyObject *self, ...)
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    PyObject *args[8];
+    int nargs = 1;
+    va_list va;
+    va_start(va, self);
+    for ( PyObject *arg; nargs < int(qnumber(args)) && (arg = va_arg(va, PyObject *)) != NULL; )
+      args[nargs++] = arg;
+    va_end(va);
+
+    if ( py_name == NULL )
+    {
+      py_name = PyString_InternFromString(name);
+      if ( py_name == NULL )
+        return NULL;
+    }
+
+    // What does 'self.<name>' resolve to?
+    PyObject *func = NULL;
+    bool pass_self = false;
+    if ( !PyInstance_Check(self) )
+    {
+      PyObject *cls_attr = _PyType_Lookup(Py_TYPE(self), py_name);
+      PyObject *inst_attr = NULL;
+      PyObject **dictptr = _PyObject_GetDictPtr(self);
+      if ( dictptr != NULL && *dictptr != NULL )
+        inst_attr = PyDict_GetItem(*dictptr, py_name);
+      if ( inst_attr != NULL && cls_attr == NULL )
+      {
+        func = inst_attr;
+      }
+      else if ( inst_attr == NULL && cls_attr != NULL && PyFunction_Check(cls_attr) )
+      {
+        func = cls_attr;
+        pass_self = true;
+      }
+    }
+    // The call may release the attribute (e.g., if it reassigns it)
+    ref_t py_func;
+    if ( func != NULL )
+    {
+      py_func = borref_t(func);
+    }
+    else
+    {
+      // Anything else (descriptors, classic classes, ...): the slow way
+      py_func = newref_t(PyObject_GetAttr(self, py_name));
+      if ( py_func == NULL )
+        return NULL;
+    }
+
+    int first = pass_self ? 0 : 1;
+    args[0] = self;
+    newref_t py_args(PyTuple_New(nargs - first));
+    if ( py_args == NULL )
+      return NULL;
+    for ( int i = first; i < nargs; ++i )
+    {
+      Py_INCREF(args[i]);
+      PyTuple_SET_ITEM(py_args.o, i - first, args[i]);
+    }
+    return PyObject_Call(py_func.o, py_args.o, NULL);
+  }
+};
+
 //------------------------------------------------------------------------
 // check if we have a file which is known to be executed automatically
 // by SWIG or Python runtime
@@ -694,6 +855,29 @@ def disable_script_timeout():
 */
 void disable_script_timeout();
 
+/*
+#<pydoc>
+def set_script_break_mode(mode):
+    """
+    Changes how the running scripts check for the script timeout and for
+    the wait box Cancel button. The new mode is used from the next script
+    execution on.
+
+    @param mode: SCRIPT_BREAK_TRACE (the default): a trace function is
+                 called on every interpreter event.
+                 SCRIPT_BREAK_WATCHDOG: a watchdog thread periodically
+                 schedules the check (see Py_AddPendingCall), which costs
+                 nothing to the script in between. The checks only start
+                 once the script timeout has elapsed: until then, the
+                 Cancel button of a wait box shown by the script itself
+                 does not interrupt it.
+    @return: Returns the old mode, or -1 if 'mode' is invalid
+    """
+    pass
+#</pydoc>
+*/
+int set_script_break_mode(int mode);
+
 /*
 #<pydoc>
 def enable_extlang_python(enable):
@@ -19,6 +19,8 @@ import sys
 import bisect
 import __builtin__
 import imp
+import marshal
+import hashlib
 
 def require(modulename, package=None):
     """
@@ -56,6 +58,10 @@ SEEK_SET = 0 # from the file start
 SEEK_CUR = 1 # from the current position
 SEEK_END = 2 # from the file end
 
+# Script break modes (see set_script_break_mode())
+SCRIPT_BREAK_TRACE    = 0 # a trace function, called on every interpreter event
+SCRIPT_BREAK_WATCHDOG = 1 # a watchdog thread, that schedules pending calls
+
 # Plugin constants
 PLUGIN_MOD  = 0x0001
 PLUGIN_DRAW = 0x0002
@@ -434,6 +440,124 @@ def IDAPython_FormatExc(etype, value, tb, limit=None):
         return str(value)
 
 
+# ------------------------------------------------------------
+# Compiled scripts cache.
+# The code objects of the scripts run by IDAPython_ExecScript() are kept
+# in 'pycache' under the user IDA directory, one file per script path.
+# A cache file starts with the interpreter magic, followed by the marshaled
+# tuple (path, mtime, size, code): it is used only if the script did not
+# change since it was compiled.
+__script_cache_stats = { "hits": 0, "misses": 0, "errors": 0 }
+__script_cache_enabled = True
+
+def __script_cache_file(path):
+    cachedir = os.path.join(get_user_idadir(), "pycache")
+    name = os.path.splitext(os.path.basename(path))[0]
+    if isinstance(path, unicode):
+        path = path.encode("utf-8")
+    return cachedir, os.path.join(
+        cachedir,
+        "%s.%s.pyc" % (name, hashlib.sha1(path).hexdigest()[:16]))
+
+
+def __script_cache_load(cachefile, key):
+    try:
+        with open(cachefile, "rb") as f:
+            if f.read(4) != imp.get_magic():
+                return None
+            data = marshal.load(f)
+    except IOError:
+        return None
+    except (EOFError, ValueError, TypeError):
+        __script_cache_stats["errors"] += 1
+        return None
+    if type(data) is not tuple or len(data) != 4 or data[:3] != key:
+        return None
+    return data[3]
+
+
+def __script_cache_store(cachedir, cachefile, key, code):
+    tmpfile = "%s.%d.tmp" % (cachefile, os.getpid())
+    try:
+        if not os.path.isdir(cachedir):
+            os.makedirs(cachedir)
+        with open(tmpfile, "wb") as f:
+            f.write(imp.get_magic())
+            marshal.dump(key + (code,), f)
+        try:
+            os.rename(tmpfile, cachefile)
+        except OSError:
+            # os.rename() does not replace an existing file on Windows
+            try:
+                os.remove(cachefile)
+                os.rename(tmpfile, cachefile)
+            except OSError:
+                # Another IDA instance wrote the same cache file in the
+                # meantime: keep its copy
+                if not os.path.exists(cachefile):
+                    raise
+                os.remove(tmpfile)
+    except (IOError, OSError, ValueError):
+        __script_cache_stats["errors"] += 1
+        try:
+            os.remove(tmpfile)
+        except OSError:
+            pass
+
+
+def IDAPython_CompileScript(script):
+    """
+    Returns the code object of a script, from the compiled scripts cache
+    if the script did not change since it was last compiled.
+    Raises the compilation errors, as execfile() would.
+    """
+    path = os.path.abspath(script)
+    with open(path, "rU") as f:
+        st = os.fstat(f.fileno())
+        if not __script_cache_enabled:
+            return compile(f.read(), script, "exec", 0, True)
+
+        key = (path, st.st_mtime, st.st_size)
+        cachedir, cachefile = __script_cache_file(path)
+        code = __script_cache_load(cachefile, key)
+        if code is not None and code.co_filename == script:
+            __script_cache_stats["hits"] += 1
+            return code
+
+        __script_cache_stats["misses"] += 1
+        code = compile(f.read(), script, "exec", 0, True)
+    __script_cache_store(cachedir, cachefile, key, code)
+    return code
+
+
+def enable_script_cache(enable):
+    """
+    Enables or disables the compiled scripts cache used by
+    IDAPython_ExecScript() (and thus by File/Script file, idapythonrc.py, ...)
+
+    @return: Boolean, the previous state
+    """
+    global __script_cache_enabled
+    old = __script_cache_enabled
+    __script_cache_enabled = bool(enable)
+    return old
+
+
+def get_script_cache_stats():
+    """
+    Returns the statistics of the compiled scripts cache, as a dictionary:
+      - hits: scripts loaded from the cache
+      - misses: scripts compiled from source
+      - errors: unreadable or unwritable cache files
+    """
+    return dict(__script_cache_stats)
+
+
+def reset_script_cache_stats():
+    """Resets the statistics of the compiled scripts cache"""
+    for k in __script_cache_stats:
+        __script_cache_stats[k] = 0
+
 # ------------------------------------------------------------
 def IDAPython_ExecScript(script, g):
     """
@@ -454,7 +578,7 @@ def IDAPython_ExecScript(script, g):
     g['__file__'] = script
 
     try:
-        execfile(script, g)
+        exec IDAPython_CompileScript(script) in g
         PY_COMPILE_ERR = None
     except Exception as e:
         PY_COMPILE_ERR = "%s\n%s" % (str(e), traceback.format_exc())
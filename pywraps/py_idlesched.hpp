@@ -0,0 +1,402 @@
+#ifndef __PY_IDLESCHED__
+#define __PY_IDLESCHED__
+
+//---------------------------------------------------------------------------
+//<code(py_kernwin)>
+//---------------------------------------------------------------------------
+// Idle scheduler: runs Python iterators ("jobs", usually generators) from
+// UI requests. Every UI loop iteration gets one time slice, during which
+// the jobs are advanced one next() ("unit of work") at a time, highest
+// priority first, and round-robin among equal priorities.
+//---------------------------------------------------------------------------
+#define IDLE_SCHED_POLL_MS 200 // how often we check if the auto-analysis is done
+
+enum idle_job_state_t
+{
+  IJS_QUEUED,
+  IJS_DONE,
+  IJS_FAILED,           // the iterator raised an exception
+  IJS_REMOVED,
+};
+
+struct idle_job_t
+{
+  int id;
+  int priority;
+  idle_job_state_t state;
+  qstring name;
+  ref_t py_iter;        // NULL once the job is over
+  uint64 last_run;      // for round-robin
+  uint64 last_slice;    // last slice that advanced this job
+  uint64 units;
+  uint64 slices;
+  uint64 busy_ns;       // time spent in next()
+  uint64 added_ns;
+  uint64 ended_ns;
+};
+typedef qvector<idle_job_t *> idle_jobs_t;
+
+//---------------------------------------------------------------------------
+class idle_scheduler_t
+{
+  struct request_t : public ui_request_t
+  {
+    idle_scheduler_t *sched;    // NULL if the scheduler is gone
+    request_t(idle_scheduler_t *_sched) : sched(_sched) {}
+    virtual bool idaapi run()
+    {
+      return sched != NULL && sched->run_slice();
+    }
+  };
+
+  idle_jobs_t jobs;             // queued jobs first, then the finished ones
+  size_t nqueued;
+  request_t *req;               // pending UI request, or NULL
+  qtimer_t timer;               // waiting for the auto-analysis, or NULL
+  int budget_ms;
+  bool pause_on_analysis;
+  bool paused;
+  bool running;                 // in run_slice()
+  bool doomed;                  // destroy() was called from a job
+  bool reset_pending;           // reset_stats() was called from a job
+  int next_id;
+  uint64 counter;               // for idle_job_t::last_run
+  uint64 nslices;
+
+  //-------------------------------------------------------------------------
+  static int idaapi timer_cb(void *ud)
+  {
+    idle_scheduler_t *_this = (idle_scheduler_t *)ud;
+    if ( !autoIsOk() )
+      return IDLE_SCHED_POLL_MS;
+    _this->timer = NULL;
+    _this->schedule();
+    return -1;
+  }
+
+  //-------------------------------------------------------------------------
+  // Highest priority, least recently run queued job
+  idle_job_t *pick() const
+  {
+    idle_job_t *best = NULL;
+    for ( size_t i = 0; i < nqueued; ++i )
+    {
+      idle_job_t *job = jobs[i];
+      if ( best == NULL
+        || job->priority > best->priority
+        || (job->priority == best->priority && job->last_run < best->last_run) )
+      {
+        best = job;
+      }
+    }
+    return best;
+  }
+
+  //-------------------------------------------------------------------------
+  // Moves a queued job to the finished ones. Must be called with the GIL.
+  void finish(idle_job_t *job, idle_job_state_t state)
+  {
+    if ( job->state != IJS_QUEUED )
+      return;
+    job->state = state;
+    job->ended_ns = get_nsec_stamp();
+    job->py_iter = ref_t();
+    idle_jobs_t::iterator p = jobs.find(job);
+    jobs.erase(p);
+    jobs.insert(jobs.begin() + --nqueued, job);
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  void run_unit(idle_job_t *job)
+  {
+    job->last_run = ++counter;
+    if ( job->last_slice != nslices )
+    {
+      job->last_slice = nslices;
+      ++job->slices;
+    }
+    // The job may remove itself (or others) from the scheduler
+    ref_t py_iter = job->py_iter;
+    uint64 t0 = get_nsec_stamp();
+    newref_t py_item(PyIter_Next(py_iter.o));
+    job->busy_ns += get_nsec_stamp() - t0;
+    if ( py_item != NULL )
+    {
+      ++job->units;
+    }
+    else if ( PyErr_Occurred() )
+    {
+      msg("IDAPython: idle job \"%s\" failed:\n", job->name.c_str());
+      PyErr_Print();
+      finish(job, IJS_FAILED);
+    }
+    else
+    {
+      finish(job, IJS_DONE);
+    }
+  }
+
+  //-------------------------------------------------------------------------
+  // Called from the UI request. Returns true to be called again.
+  bool run_slice()
+  {
+    if ( running )
+      return true; // a job is processing the UI events: wait for it
+    if ( paused || nqueued == 0 )
+    {
+      req = NULL;
+      return false;
+    }
+    if ( pause_on_analysis && !autoIsOk() )
+    {
+      req = NULL;
+      schedule();
+      return false;
+    }
+
+    PYW_GIL_GET;
+    running = true;
+    ++nslices;
+    uint64 deadline = get_nsec_stamp() + uint64(budget_ms) * 1000000;
+    do
+    {
+      idle_job_t *job = pick();
+      if ( job == NULL )
+        break;
+      run_unit(job);
+    }
+    while ( !paused && !doomed && get_nsec_stamp() < deadline );
+    running = false;
+    if ( reset_pending )
+      reset_stats();
+
+    if ( doomed )
+    {
+      req = NULL;
+      delete this;
+      return false;
+    }
+    if ( paused || nqueued == 0 )
+    {
+      req = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  //-------------------------------------------------------------------------
+  // Queues a UI request if there is work to do
+  void schedule()
+  {
+    if ( paused || req != NULL || timer != NULL || nqueued == 0 )
+      return;
+    if ( pause_on_analysis && !autoIsOk() )
+    {
+      timer = register_timer(IDLE_SCHED_POLL_MS, timer_cb, this);
+      return;
+    }
+    req = new request_t(this);
+    execute_ui_requests(req, NULL);
+  }
+
+  //-------------------------------------------------------------------------
+  ~idle_scheduler_t()
+  {
+    if ( req != NULL )
+      req->sched = NULL; // the kernel will delete it
+    if ( timer != NULL )
+      unregister_timer(timer);
+    for ( size_t i = 0; i < jobs.size(); ++i )
+      delete jobs[i];
+  }
+
+public:
+  idle_scheduler_t(int _budget_ms, bool _pause_on_analysis)
+    : nqueued(0), req(NULL), timer(NULL),
+      budget_ms(qmax(_budget_ms, 1)), pause_on_analysis(_pause_on_analysis),
+      paused(false), running(false), doomed(false), reset_pending(false),
+      next_id(1), counter(0), nslices(0) {}
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  void destroy()
+  {
+    if ( running )
+      doomed = true; // run_slice() will delete us
+    else
+      delete this;
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  int add(PyObject *py_iter, int priority, const char *name)
+  {
+    idle_job_t *job = new idle_job_t();
+    job->id = next_id++;
+    job->priority = priority;
+    job->state = IJS_QUEUED;
+    job->name = name != NULL ? name : "";
+    job->py_iter = borref_t(py_iter);
+    job->last_run = 0; // new jobs go first
+    job->last_slice = 0;
+    job->units = job->slices = job->busy_ns = 0;
+    job->added_ns = get_nsec_stamp();
+    job->ended_ns = 0;
+    jobs.insert(jobs.begin() + nqueued++, job);
+    schedule();
+    return job->id;
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  bool remove(int id)
+  {
+    for ( size_t i = 0; i < nqueued; ++i )
+    {
+      if ( jobs[i]->id == id )
+      {
+        finish(jobs[i], IJS_REMOVED);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //-------------------------------------------------------------------------
+  void pause(bool pause)
+  {
+    paused = pause;
+    if ( !paused )
+      schedule();
+  }
+
+  //-------------------------------------------------------------------------
+  // Forgets the finished jobs. Must be called with the GIL.
+  void reset_stats()
+  {
+    // The running job may be one of them
+    reset_pending = running;
+    if ( reset_pending )
+      return;
+    for ( size_t i = nqueued; i < jobs.size(); ++i )
+      delete jobs[i];
+    jobs.resize(nqueued);
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  PyObject *get_stats() const
+  {
+    static const char *const states[] = { "queued", "done", "failed", "removed" };
+    newref_t py_list(PyList_New(jobs.size()));
+    if ( py_list == NULL )
+      return NULL;
+    uint64 now = get_nsec_stamp();
+    for ( size_t i = 0; i < jobs.size(); ++i )
+    {
+      const idle_job_t *job = jobs[i];
+      double busy_s = job->busy_ns / 1e9;
+      PyObject *py_job = Py_BuildValue(
+              "{s:i,s:s,s:i,s:s,s:K,s:K,s:K,s:K,s:d}",
+              "id", job->id,
+              "name", job->name.c_str(),
+              "priority", job->priority,
+              "state", states[job->state],
+              "units", (unsigned PY_LONG_LONG)job->units,
+              "slices", (unsigned PY_LONG_LONG)job->slices,
+              "busy_ns", (unsigned PY_LONG_LONG)job->busy_ns,
+              "elapsed_ns", (unsigned PY_LONG_LONG)((job->state == IJS_QUEUED ? now : job->ended_ns) - job->added_ns),
+              "units_per_sec", busy_s > 0 ? job->units / busy_s : 0.0);
+      if ( py_job == NULL )
+        return NULL;
+      PyList_SET_ITEM(py_list.o, i, py_job);
+    }
+    py_list.incref();
+    return py_list.o;
+  }
+};
+
+//---------------------------------------------------------------------------
+static void idaapi idle_scheduler_free(void *ptr)
+{
+  ((idle_scheduler_t *)ptr)->destroy();
+}
+
+//---------------------------------------------------------------------------
+static idle_scheduler_t *get_idle_scheduler(PyObject *py_sched)
+{
+  if ( !PyCObject_Check(py_sched) )
+  {
+    PyErr_SetString(PyExc_TypeError, "Expected an idle scheduler");
+    return NULL;
+  }
+  return (idle_scheduler_t *)PyCObject_AsVoidPtr(py_sched);
+}
+
+//---------------------------------------------------------------------------
+PyObject *idle_scheduler_create(int budget_ms, bool pause_on_analysis)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = new idle_scheduler_t(budget_ms, pause_on_analysis);
+  return PyCObject_FromVoidPtr(sched, idle_scheduler_free);
+}
+
+//---------------------------------------------------------------------------
+int idle_scheduler_add(PyObject *py_sched, PyObject *py_job, int priority, const char *name)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched == NULL || !PyIter_Check(py_job) )
+    return -1;
+  return sched->add(py_job, priority, name);
+}
+
+//---------------------------------------------------------------------------
+bool idle_scheduler_remove(PyObject *py_sched, int job_id)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  return sched != NULL && sched->remove(job_id);
+}
+
+//---------------------------------------------------------------------------
+void idle_scheduler_pause(PyObject *py_sched, bool pause)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched != NULL )
+    sched->pause(pause);
+}
+
+//---------------------------------------------------------------------------
+void idle_scheduler_reset_stats(PyObject *py_sched)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched != NULL )
+    sched->reset_stats();
+}
+
+//---------------------------------------------------------------------------
+PyObject *idle_scheduler_get_stats(PyObject *py_sched)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched == NULL )
+    return NULL;
+  return sched->get_stats();
+}
+//</code(py_kernwin)>
+
+//---------------------------------------------------------------------------
+//<inline(py_kernwin)>
+PyObject *idle_scheduler_create(int budget_ms, bool pause_on_analysis);
+int idle_scheduler_add(PyObject *py_sched, PyObject *py_job, int priority, const char *name);
+bool idle_scheduler_remove(PyObject *py_sched, int job_id);
+void idle_scheduler_pause(PyObject *py_sched, bool pause);
+void idle_scheduler_reset_stats(PyObject *py_sched);
+PyObject *idle_scheduler_get_stats(PyObject *py_sched);
+//</inline(py_kernwin)>
+
+#endif
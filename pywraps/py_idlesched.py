@@ -0,0 +1,108 @@
+# -----------------------------------------------------------------------
+# Standalone and testing code
+import sys
+try:
+    import pywraps
+    pywraps_there = True
+    print "Using pywraps"
+except:
+    pywraps_there = False
+    print "Not using pywraps"
+
+try:
+    import _idaapi
+except:
+    print "Please try me from inside IDA"
+    sys.exit(0)
+
+if pywraps_there:
+    _idaapi.idle_scheduler_create      = pywraps.idle_scheduler_create
+    _idaapi.idle_scheduler_add         = pywraps.idle_scheduler_add
+    _idaapi.idle_scheduler_remove      = pywraps.idle_scheduler_remove
+    _idaapi.idle_scheduler_pause       = pywraps.idle_scheduler_pause
+    _idaapi.idle_scheduler_reset_stats = pywraps.idle_scheduler_reset_stats
+    _idaapi.idle_scheduler_get_stats   = pywraps.idle_scheduler_get_stats
+
+# -----------------------------------------------------------------------
+#<pycode(py_kernwin)>
+class IdleScheduler(object):
+    """
+    Runs background jobs on the main thread, in time slices, while the
+    user interface stays responsive.
+
+    A job is an iterable, usually a generator, that yields between its
+    units of work. Every UI loop iteration gives the scheduler one time
+    slice of 'budget_ms' milliseconds, during which the jobs are advanced
+    one unit at a time: highest priority first, round-robin among the
+    jobs of equal priority.
+
+    Example:
+        def rename_all():
+            for ea in Functions():
+                ...
+                yield
+
+        sched = IdleScheduler(budget_ms = 10)
+        sched.add(rename_all())
+
+    The jobs stop when the scheduler is deleted: keep a reference to it.
+    """
+    def __init__(self, budget_ms = 20, pause_on_analysis = True):
+        """
+        @param budget_ms: length of the time slices
+        @param pause_on_analysis: do not run the jobs while the
+                                  auto-analysis is busy
+        """
+        self.__sched = _idaapi.idle_scheduler_create(budget_ms, pause_on_analysis)
+
+    def add(self, job, priority = 0, name = None):
+        """
+        Queues a job.
+
+        @param job: an iterable (a generator, ...). Each value it produces
+                    ends a unit of work, and the values are ignored.
+        @param priority: the jobs with the highest priority run first
+        @param name: name of the job in the statistics
+        @return: the job id
+        """
+        if name is None:
+            name = getattr(job, "__name__", None) or type(job).__name__
+        return _idaapi.idle_scheduler_add(self.__sched, iter(job), priority, name)
+
+    def remove(self, job_id):
+        """
+        Removes a queued job.
+
+        @return: Boolean. False if the job is not queued anymore
+        """
+        return _idaapi.idle_scheduler_remove(self.__sched, job_id)
+
+    def pause(self):
+        """Stops running the jobs, until resume()"""
+        _idaapi.idle_scheduler_pause(self.__sched, True)
+
+    def resume(self):
+        """Runs the jobs again after pause()"""
+        _idaapi.idle_scheduler_pause(self.__sched, False)
+
+    def get_stats(self):
+        """
+        Returns the statistics of the jobs, as a list of dictionaries with
+        the following keys:
+          - id, name, priority
+          - state: 'queued', 'done', 'failed' (it raised an exception)
+                   or 'removed'
+          - units: number of units of work done
+          - slices: number of time slices the job ran in
+          - busy_ns: time spent in the job
+          - elapsed_ns: time since the job was added, until it ended
+          - units_per_sec: throughput of the job (units / busy time)
+        The finished jobs are listed until reset_stats().
+        """
+        return _idaapi.idle_scheduler_get_stats(self.__sched)
+
+    def reset_stats(self):
+        """Forgets the finished jobs"""
+        _idaapi.idle_scheduler_reset_stats(self.__sched)
+
+#</pycode(py_kernwin)>
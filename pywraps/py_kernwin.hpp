@@ -614,11 +614,16 @@ def execute_sync(callable, reqf):
     If the current thread not the main thread, then the call is queued and
     executed afterwards.
 
-    @note: The Python version of execute_sync() cannot be called from a different thread
-           for the time being.
+    @note: It can be called from threading.Thread threads. It releases
+           the GIL while the request is queued, but the main thread must
+           not wait for the calling thread in the meantime (with join(),
+           for example), or they will deadlock.
+           If the callable raises an exception, it is printed and -1 is
+           returned. Use execute_async() to get any result, or the
+           exception, back.
     @param callable: A python callable object
     @param reqf: one of MFF_ flags
-    @return: -1 or the return value of the callable
+    @return: -1 or the return value of the callable, if it is an integer
     """
     pass
 #</pydoc>
@@ -638,6 +643,9 @@ static int py_execute_sync(PyObject *py_callable, int reqf)
       {
         PYW_GIL_GET;
         newref_t py_result(PyObject_CallFunctionObjArgs(py_callable.o, NULL));
+        // Don't leave the exception pending on the main thread
+        if ( py_result == NULL )
+          PyErr_Print();
         int ret = py_result == NULL || !PyInt_Check(py_result.o)
                 ? -1
                 : PyInt_AsLong(py_result.o);
@@ -677,6 +685,112 @@ static int py_execute_sync(PyObject *py_callable, int reqf)
   return rc;
 }
 
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def py_execute_async(calls, reqf):
+    """
+    Internal: executes the callables on the main thread, in one request,
+    and passes their results to their futures. See execute_async().
+
+    @param calls: a list of (callable, future) tuples
+    @param reqf: one of MFF_ flags (MFF_NOWAIT is implied)
+    @return: Boolean. False if the list is invalid
+    """
+    pass
+#</pydoc>
+*/
+static bool py_execute_async(PyObject *py_calls, int reqf)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( !PyList_Check(py_calls) )
+    return false;
+  Py_ssize_t n = PyList_Size(py_calls);
+  for ( Py_ssize_t i = 0; i < n; ++i )
+  {
+    PyObject *py_item = PyList_GET_ITEM(py_calls, i);
+    if ( !PyTuple_Check(py_item)
+      || PyTuple_Size(py_item) != 2
+      || !PyCallable_Check(PyTuple_GET_ITEM(py_item, 0)) )
+    {
+      return false;
+    }
+  }
+  if ( n == 0 )
+    return true;
+
+  struct py_async_request_t : exec_request_t
+  {
+    ref_t py_calls;
+
+    // Passes the result of a call, or its exception, to the future
+    static void resolve(PyObject *py_future, PyObject *py_result)
+    {
+      if ( py_result != NULL )
+      {
+        newref_t py_ret(PyObject_CallMethod(py_future, (char *)"_set_result", (char *)"(O)", py_result));
+        if ( py_ret == NULL )
+          PyErr_Print();
+        return;
+      }
+      PyObject *py_type, *py_value, *py_tb;
+      PyErr_Fetch(&py_type, &py_value, &py_tb);
+      PyErr_NormalizeException(&py_type, &py_value, &py_tb);
+      newref_t py_ret(PyObject_CallMethod(
+                        py_future,
+                        (char *)"_set_exception",
+                        (char *)"(OOO)",
+                        py_type,
+                        py_value != NULL ? py_value : Py_None,
+                        py_tb != NULL ? py_tb : Py_None));
+      if ( py_ret == NULL )
+        PyErr_Print();
+      Py_XDECREF(py_type);
+      Py_XDECREF(py_value);
+      Py_XDECREF(py_tb);
+    }
+
+    virtual int idaapi execute()
+    {
+      {
+        PYW_GIL_GET;
+        Py_ssize_t n = PyList_Size(py_calls.o);
+        for ( Py_ssize_t i = 0; i < n; ++i )
+        {
+          PyObject *py_item = PyList_GET_ITEM(py_calls.o, i);
+          newref_t py_result(PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(py_item, 0), NULL));
+          resolve(PyTuple_GET_ITEM(py_item, 1), py_result.o);
+        }
+      }
+      // Nobody waits for us: self-destroy
+      delete this;
+      return 0;
+    }
+    py_async_request_t(PyObject *py_list)
+    {
+      // Our own copy: the caller may modify the list
+      py_calls = newref_t(PyList_GetSlice(py_list, 0, PyList_Size(py_list)));
+    }
+    virtual ~py_async_request_t()
+    {
+      // Might be called from the main thread
+      PYW_GIL_GET;
+      py_calls = ref_t();
+    }
+  };
+  py_async_request_t *req = new py_async_request_t(py_calls);
+  if ( req->py_calls == NULL )
+  {
+    delete req;
+    PyErr_Clear();
+    return false;
+  }
+  Py_BEGIN_ALLOW_THREADS;
+  execute_sync(*req, reqf | MFF_NOWAIT);
+  Py_END_ALLOW_THREADS;
+  return true;
+}
+
 //------------------------------------------------------------------------
 /*
 #<pydoc>
@@ -1205,6 +1319,7 @@ int idaapi UI_Callback(void *ud, int notification_code, va_list va)
   // This hook gets called from the kernel. Ensure we hold the GIL.
   PYW_GIL_GET;
   UI_Hooks *proxy = (UI_Hooks *)ud;
+  hook_timer_t timer("UI_Hooks", notification_code, proxy);
   int ret = 0;
   try
   {
@@ -94,6 +94,96 @@ class action_handler_t:
     def update(self, ctx):
         pass
 
+# ----------------------------------------------------------------------
+class execute_future_t(object):
+    """
+    Result of a callable queued with execute_async()
+    """
+    def __init__(self):
+        import threading
+        self._done = threading.Event()
+        self._result = None
+        self._exc_info = None
+
+    def _set_result(self, result):
+        self._result = result
+        self._done.set()
+
+    def _set_exception(self, type, value, tb):
+        self._exc_info = (type, value, tb)
+        self._done.set()
+
+    def done(self):
+        """Returns True if the callable was executed"""
+        return self._done.is_set()
+
+    def wait(self, timeout=None):
+        """
+        Waits for the callable to be executed.
+        Must not be called from the main thread (which executes it).
+
+        @param timeout: in seconds, or None to wait forever
+        @return: Boolean. False on timeout
+        """
+        if not self._done.is_set():
+            import threading
+            if isinstance(threading.current_thread(), threading._MainThread):
+                raise RuntimeError("Cannot wait for execute_async() on the main thread")
+            self._done.wait(timeout)
+        return self._done.is_set()
+
+    def result(self, timeout=None):
+        """
+        Waits for the callable, and returns its result, or raises its exception.
+        Raises RuntimeError on timeout.
+        """
+        if not self.wait(timeout):
+            raise RuntimeError("execute_async() timed out")
+        if self._exc_info is not None:
+            raise self._exc_info[0], self._exc_info[1], self._exc_info[2]
+        return self._result
+
+    def exception(self, timeout=None):
+        """
+        Waits for the callable, and returns the exception it raised, or None.
+        Raises RuntimeError on timeout.
+        """
+        if not self.wait(timeout):
+            raise RuntimeError("execute_async() timed out")
+        return None if self._exc_info is None else self._exc_info[1]
+
+# ----------------------------------------------------------------------
+def execute_async_batch(callables, reqf=MFF_WRITE):
+    """
+    Executes callables in the context of the main thread, in the order
+    of the list, during a single request, without waiting for them.
+    Can be called from any thread.
+
+    @param callables: a list of python callable objects
+    @param reqf: one of MFF_ flags (MFF_NOWAIT is implied)
+    @return: a list of execute_future_t objects, one per callable
+    """
+    callables = list(callables)
+    futures = [execute_future_t() for c in callables]
+    if not _idaapi.py_execute_async(zip(callables, futures), reqf):
+        raise ValueError("Expected a list of callables")
+    return futures
+
+# ----------------------------------------------------------------------
+def execute_async(callable, reqf=MFF_WRITE):
+    """
+    Executes a callable in the context of the main thread, without waiting
+    for it. Can be called from any thread.
+    execute_async(f).result() is like execute_sync(f, reqf), except that
+    the result can be any Python object, and the exception raised by the
+    callable, if any, is raised again.
+
+    @param callable: a python callable object
+    @param reqf: one of MFF_ flags (MFF_NOWAIT is implied)
+    @return: an execute_future_t object
+    """
+    return execute_async_batch([callable], reqf)[0]
+
 #</pycode(py_kernwin)>
 
 # ----------------------------------------------------------------------
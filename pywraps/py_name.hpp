@@ -1,5 +1,133 @@
 //-------------------------------------------------------------------------
 //<code(py_name)>
+//-------------------------------------------------------------------------
+// A table of snapshot_tables(), in columnar form: up to two address-sized
+// columns, and a name per row stored in a string arena shared by all tables
+struct snap_table_t
+{
+  const char *title;
+  const char *colnames[2];          // NULL for unused columns
+  eavec_t cols[2];
+  qvector<uint32> name_offs;        // rows+1 offsets into the arena
+
+  snap_table_t(const char *_title, const char *col0, const char *col1 = NULL)
+    : title(_title)
+  {
+    colnames[0] = col0;
+    colnames[1] = col1;
+  }
+
+  void add_row(qstring *arena, const char *name, ea_t v0, ea_t v1 = BADADDR)
+  {
+    if ( name_offs.empty() )
+      name_offs.push_back(uint32(arena->length()));
+    cols[0].push_back(v0);
+    if ( colnames[1] != NULL )
+      cols[1].push_back(v1);
+    if ( name != NULL )
+      arena->append(name);
+    name_offs.push_back(uint32(arena->length()));
+  }
+};
+typedef qvector<snap_table_t *> snap_tables_t;
+
+//-------------------------------------------------------------------------
+// The snap_...() functions must be called without the GIL
+static void snap_names(snap_table_t *t, qstring *arena)
+{
+  size_t n = get_nlist_size();
+  t->cols[0].reserve(n);
+  t->name_offs.reserve(n + 1);
+  for ( size_t i = 0; i < n; ++i )
+    t->add_row(arena, get_nlist_name(i), get_nlist_ea(i));
+}
+
+//-------------------------------------------------------------------------
+static void snap_segments(snap_table_t *t, qstring *arena)
+{
+  char buf[MAXSTR];
+  int n = get_segm_qty();
+  for ( int i = 0; i < n; ++i )
+  {
+    segment_t *seg = getnseg(i);
+    if ( seg == NULL )
+      continue;
+    if ( get_true_segm_name(seg, buf, sizeof(buf)) <= 0 )
+      buf[0] = '\0';
+    t->add_row(arena, buf, seg->startEA, seg->endEA);
+  }
+}
+
+//-------------------------------------------------------------------------
+static void snap_entries(snap_table_t *t, qstring *arena)
+{
+  char buf[MAXSTR];
+  size_t n = get_entry_qty();
+  for ( size_t i = 0; i < n; ++i )
+  {
+    uval_t ord = get_entry_ordinal(i);
+    if ( get_entry_name(ord, buf, sizeof(buf)) <= 0 )
+      buf[0] = '\0';
+    t->add_row(arena, buf, ea_t(ord), get_entry(ord));
+  }
+}
+
+//-------------------------------------------------------------------------
+static void snap_functions(snap_table_t *t, qstring *arena)
+{
+  char buf[MAXSTR];
+  size_t n = get_func_qty();
+  for ( size_t i = 0; i < n; ++i )
+  {
+    func_t *pfn = getn_func(i);
+    if ( pfn == NULL )
+      continue;
+    if ( get_func_name(pfn->startEA, buf, sizeof(buf)) == NULL )
+      buf[0] = '\0';
+    t->add_row(arena, buf, pfn->startEA, pfn->endEA);
+  }
+}
+
+//-------------------------------------------------------------------------
+static void snap_structs(snap_table_t *t, qstring *arena)
+{
+  char buf[MAXSTR];
+  size_t n = get_struc_qty();
+  for ( size_t i = 0; i < n; ++i )
+  {
+    tid_t sid = get_struc_by_idx(i);
+    if ( get_struc_name(sid, buf, sizeof(buf)) <= 0 )
+      buf[0] = '\0';
+    t->add_row(arena, buf, ea_t(sid));
+  }
+}
+
+//-------------------------------------------------------------------------
+// Converts one table to {colname: array, ..., 'name': offsets}
+static PyObject *snap_table_to_py(const snap_table_t &t)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  newref_t py_table(PyDict_New());
+  if ( py_table == NULL )
+    return NULL;
+  for ( size_t i = 0; i < qnumber(t.colnames); ++i )
+  {
+    if ( t.colnames[i] == NULL )
+      continue;
+    newref_t py_col(eavec_to_pyarray(t.cols[i]));
+    if ( py_col == NULL || PyDict_SetItemString(py_table.o, t.colnames[i], py_col.o) != 0 )
+      return NULL;
+  }
+  // an empty table still has its initial offset
+  qvector<uint32> offs(t.name_offs);
+  if ( offs.empty() )
+    offs.push_back(0);
+  newref_t py_offs(pyw_array_from_data("I", offs.begin(), offs.size()));
+  if ( py_offs == NULL || PyDict_SetItemString(py_table.o, "name", py_offs.o) != 0 )
+    return NULL;
+  py_table.incref();
+  return py_table.o;
+}
 //</code(py_name)>
 
 //------------------------------------------------------------------------
@@ -33,6 +161,99 @@ inline qstring py_get_ea_name(ea_t ea, int gtn_flags=0)
   get_ea_name(&out, ea, gtn_flags);
   return out;
 }
+//------------------------------------------------------------------------
+#define SNAP_NAMES      0x01
+#define SNAP_SEGMENTS   0x02
+#define SNAP_ENTRIES    0x04
+#define SNAP_FUNCTIONS  0x08
+#define SNAP_STRUCTS    0x10
+#define SNAP_ALL        0x1F
+
+/*
+#<pydoc>
+def snapshot_tables(which = SNAP_ALL):
+    """
+    Takes a columnar snapshot of the names, segments, entry points,
+    functions and structures in one native pass.
+    All the strings are stored in one string arena. Each table holds a
+    'name' array.array('I') of row count + 1 offsets into that arena: the
+    name of row i is arena[name[i]:name[i+1]].
+    The address columns are array.array objects ('I' or 'L', or lists if
+    no array typecode matches the size of ea_t).
+
+    @param which: combination of SNAP_... constants
+    @return: a dictionary with an 'arena' string and one entry per
+             requested table:
+               'names':     {'ea', 'name'}
+               'segments':  {'start_ea', 'end_ea', 'name'}
+               'entries':   {'ordinal', 'ea', 'name'}
+               'functions': {'start_ea', 'end_ea', 'name'}
+               'structs':   {'id', 'name'}
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_snapshot_tables(int which = SNAP_ALL)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  snap_table_t names("names", "ea");
+  snap_table_t segments("segments", "start_ea", "end_ea");
+  snap_table_t entries("entries", "ordinal", "ea");
+  snap_table_t functions("functions", "start_ea", "end_ea");
+  snap_table_t structs("structs", "id");
+  snap_tables_t tables;
+  qstring arena;
+
+  Py_BEGIN_ALLOW_THREADS;
+  if ( (which & SNAP_NAMES) != 0 )
+  {
+    snap_names(&names, &arena);
+    tables.push_back(&names);
+  }
+  if ( (which & SNAP_SEGMENTS) != 0 )
+  {
+    snap_segments(&segments, &arena);
+    tables.push_back(&segments);
+  }
+  if ( (which & SNAP_ENTRIES) != 0 )
+  {
+    snap_entries(&entries, &arena);
+    tables.push_back(&entries);
+  }
+  if ( (which & SNAP_FUNCTIONS) != 0 )
+  {
+    snap_functions(&functions, &arena);
+    tables.push_back(&functions);
+  }
+  if ( (which & SNAP_STRUCTS) != 0 )
+  {
+    snap_structs(&structs, &arena);
+    tables.push_back(&structs);
+  }
+  Py_END_ALLOW_THREADS;
+
+  if ( uint64(arena.length()) > uint64(uint32(-1)) )
+  {
+    PyErr_SetString(PyExc_OverflowError, "Names do not fit in a 4GB arena");
+    return NULL;
+  }
+
+  newref_t py_snap(PyDict_New());
+  if ( py_snap == NULL )
+    return NULL;
+  newref_t py_arena(PyString_FromStringAndSize(arena.c_str(), arena.length()));
+  if ( py_arena == NULL || PyDict_SetItemString(py_snap.o, "arena", py_arena.o) != 0 )
+    return NULL;
+  for ( size_t i = 0; i < tables.size(); ++i )
+  {
+    newref_t py_table(snap_table_to_py(*tables[i]));
+    if ( py_table == NULL || PyDict_SetItemString(py_snap.o, tables[i]->title, py_table.o) != 0 )
+      return NULL;
+  }
+  py_snap.incref();
+  return py_snap.o;
+}
+
 //------------------------------------------------------------------------
 //</inline(py_name)>
 //------------------------------------------------------------------------
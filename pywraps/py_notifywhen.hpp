@@ -163,11 +163,17 @@ public:
     in_notify = true;
     int old = slot == NW_OPENIDB_SLOT ? va_arg(va, int) : 0;
 
+    // The NW_INITIDA and NW_OPENIDB callbacks are part of the startup profile
+    const char *profile_name = slot == NW_INITIDA_SLOT ? "NW_INITIDA"
+                             : slot == NW_OPENIDB_SLOT ? "NW_OPENIDB"
+                             : NULL;
     {
       for (ref_vec_t::iterator it = table[slot].begin(), it_end = table[slot].end();
            it != it_end;
            ++it)
       {
+        nw_timer_t timer(profile_name, it->o);
+
         // Form the notification code
         newref_t py_code(PyInt_FromLong(1 << slot));
         ref_t py_result;
@@ -197,6 +203,9 @@ public:
     }
     in_notify = false;
 
+    if ( slot == NW_OPENIDB_SLOT && !table[slot].empty() )
+      pywraps_startup_dump();
+
     // Process any delayed notify_when() calls that
     if ( !delayed_notify_when_list.empty() )
     {
@@ -0,0 +1,236 @@
+#ifndef __PYWRAPS_PROFILER__
+#define __PYWRAPS_PROFILER__
+
+//------------------------------------------------------------------------
+//<code(py_idaapi)>
+//------------------------------------------------------------------------
+// Sampling profiler: a thread periodically takes the GIL and records the
+// Python stack of the main thread. If, right before, the main thread was
+// not holding the GIL, it was inside a native call that released it (IDA
+// kernel calls, mostly), and the sample is attributed to a "[native]"
+// frame on top of the Python stack.
+// The samples are written in the "collapsed stacks" format used by the
+// flame graph tools: "frame;frame;...;frame count".
+//------------------------------------------------------------------------
+#define PROFILER_NATIVE_FRAME "[native]"
+
+class py_profiler_t
+{
+  typedef std::map<qstring, uint32> stack_counts_t;
+  stack_counts_t counts;
+  PyThreadState *main_tstate;
+  qthread_t thread;
+  qsemaphore_t sem;
+  volatile bool stopping;
+  int interval_ms;
+  uint32 nsamples;
+  uint32 nnative;
+
+  //------------------------------------------------------------------------
+  // Must be called with the GIL
+  void sample(bool in_native)
+  {
+    PyFrameObject *frames[256];
+    int n = 0;
+    for ( PyFrameObject *f = main_tstate->frame; f != NULL && n < int(qnumber(frames)); f = f->f_back )
+      frames[n++] = f;
+    if ( n == 0 )
+      return; // not running Python code
+    qstring key;
+    char buf[MAXSTR];
+    for ( int i = n - 1; i >= 0; --i )
+    {
+      PyCodeObject *co = frames[i]->f_code;
+      const char *file = PyString_Check(co->co_filename) ? PyString_AS_STRING(co->co_filename) : "?";
+      const char *name = PyString_Check(co->co_name) ? PyString_AS_STRING(co->co_name) : "?";
+      qsnprintf(buf, sizeof(buf), "%s (%s:%d)", name, qbasename(file), co->co_firstlineno);
+      if ( !key.empty() )
+        key.append(';');
+      key.append(buf);
+    }
+    if ( in_native )
+    {
+      key.append(";" PROFILER_NATIVE_FRAME);
+      ++nnative;
+    }
+    ++counts[key];
+    ++nsamples;
+  }
+
+  //------------------------------------------------------------------------
+  static int idaapi thread_cb(void *ud)
+  {
+    py_profiler_t *p = (py_profiler_t *)ud;
+    while ( true )
+    {
+      qsem_wait(p->sem, p->interval_ms);
+      if ( p->stopping )
+        break;
+      // Racy read, but it's only a hint: we can't take the GIL to check it
+      bool in_native = _PyThreadState_Current != p->main_tstate;
+      PyGILState_STATE state = PyGILState_Ensure();
+      if ( !p->stopping )
+        p->sample(in_native);
+      PyGILState_Release(state);
+    }
+    return 0;
+  }
+
+public:
+  py_profiler_t()
+    : main_tstate(NULL), thread(NULL), sem(NULL), stopping(false),
+      interval_ms(10), nsamples(0), nnative(0) {}
+
+  bool running() const { return thread != NULL; }
+
+  //------------------------------------------------------------------------
+  // Must be called from the main thread, with the GIL
+  bool start(int _interval_ms)
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    if ( running() )
+      return false;
+    counts.clear();
+    nsamples = nnative = 0;
+    interval_ms = qmax(_interval_ms, 1);
+    main_tstate = PyThreadState_Get();
+    stopping = false;
+    sem = qsem_create(NULL, 0);
+    if ( sem == NULL )
+      return false;
+    thread = qthread_create(thread_cb, this);
+    if ( thread == NULL )
+    {
+      qsem_free(sem);
+      sem = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  //------------------------------------------------------------------------
+  // Must be called with the GIL
+  bool stop()
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    if ( !running() )
+      return false;
+    stopping = true;
+    qsem_post(sem);
+    // The sampler may be waiting for the GIL
+    Py_BEGIN_ALLOW_THREADS;
+    qthread_join(thread);
+    Py_END_ALLOW_THREADS;
+    qthread_free(thread);
+    thread = NULL;
+    qsem_free(sem);
+    sem = NULL;
+    msg("IDAPython: profiler: %u samples, %u%% in native calls\n",
+        nsamples, nsamples == 0 ? 0 : uint32(uint64(nnative) * 100 / nsamples));
+    return true;
+  }
+
+  //------------------------------------------------------------------------
+  void get_collapsed(qstring *out) const
+  {
+    out->qclear();
+    char buf[32];
+    for ( stack_counts_t::const_iterator p = counts.begin(); p != counts.end(); ++p )
+    {
+      qsnprintf(buf, sizeof(buf), " %u\n", p->second);
+      out->append(p->first);
+      out->append(buf);
+    }
+  }
+
+  //------------------------------------------------------------------------
+  bool save_collapsed(const char *path) const
+  {
+    FILE *fp = qfopen(path, "w");
+    if ( fp == NULL )
+      return false;
+    qstring out;
+    get_collapsed(&out);
+    bool ok = qfwrite(fp, out.c_str(), out.length()) == ssize_t(out.length());
+    qfclose(fp);
+    return ok;
+  }
+};
+
+static py_profiler_t py_profiler;
+
+//------------------------------------------------------------------------
+bool pywraps_profiler_start(int interval_ms)
+{
+  return py_profiler.start(interval_ms);
+}
+
+//------------------------------------------------------------------------
+// Stops the profiler and writes the collapsed stacks to 'path'
+bool pywraps_profiler_stop(const char *path)
+{
+  if ( !py_profiler.stop() )
+    return false;
+  if ( path == NULL || path[0] == '\0' )
+    return true;
+  if ( !py_profiler.save_collapsed(path) )
+  {
+    msg("IDAPython: profiler: could not write \"%s\"\n", path);
+    return false;
+  }
+  msg("IDAPython: profiler: stacks written to \"%s\"\n", path);
+  return true;
+}
+//</code(py_idaapi)>
+
+//------------------------------------------------------------------------
+//<inline(py_idaapi)>
+/*
+#<pydoc>
+def profiler_start(interval_ms = 10):
+    """
+    Starts the sampling profiler. Every 'interval_ms' milliseconds, the
+    Python stack of the main thread is recorded. The time spent in native
+    calls that release the GIL (IDA kernel calls, mostly) is attributed to
+    a "[native]" frame.
+    The profiler can also be started from the command line:
+      -OIDAPython:profile=<outfile>[,<interval_ms>];[<when>;]<script>
+    @param interval_ms: sampling interval
+    @return: False if the profiler is already running
+    """
+    pass
+#</pydoc>
+*/
+static bool profiler_start(int interval_ms = 10)
+{
+  return pywraps_profiler_start(interval_ms);
+}
+
+/*
+#<pydoc>
+def profiler_stop(outfile = None):
+    """
+    Stops the sampling profiler.
+    @param outfile: file where to write the collapsed stacks (as read by
+                    flamegraph.pl), or None
+    @return: if 'outfile' is None, the collapsed stacks as a string,
+             or None if the profiler was not running.
+             Otherwise, whether the file was written.
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *profiler_stop(const char *outfile = NULL)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( outfile != NULL )
+    return PyBool_FromLong(pywraps_profiler_stop(outfile));
+  if ( !pywraps_profiler_stop(NULL) )
+    Py_RETURN_NONE;
+  qstring out;
+  py_profiler.get_collapsed(&out);
+  return PyString_FromStringAndSize(out.c_str(), out.length());
+}
+//</inline(py_idaapi)>
+
+#endif
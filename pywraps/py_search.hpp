@@ -0,0 +1,424 @@
+#ifndef __PY_IDA_SEARCH__
+#define __PY_IDA_SEARCH__
+
+//-------------------------------------------------------------------------
+//<code(py_search)>
+//-------------------------------------------------------------------------
+// Multi-pattern search: each pattern is anchored on its longest run of
+// non-wildcard bytes, all the anchors go into one Aho-Corasick automaton,
+// and the anchor hits are then verified against the whole pattern.
+//-------------------------------------------------------------------------
+struct bin_pattern_t
+{
+  bytevec_t bytes;
+  bytevec_t mask;               // 0xFF: byte must match, 0: wildcard
+  size_t anchor_off;            // offset of the anchor in the pattern
+  size_t anchor_len;
+};
+DECLARE_TYPE_AS_MOVABLE(bin_pattern_t);
+typedef qvector<bin_pattern_t> bin_patterns_t;
+
+struct ac_edge_t
+{
+  uchar byte;
+  int target;
+};
+DECLARE_TYPE_AS_MOVABLE(ac_edge_t);
+
+struct ac_state_t
+{
+  qvector<ac_edge_t> edges;     // only used for non-root states
+  int fail;                     // longest proper suffix state
+  int out;                      // next state (suffix) having patterns, or 0
+  intvec_t pats;                // patterns whose anchor ends here
+  ac_state_t() : fail(0), out(0) {}
+};
+DECLARE_TYPE_AS_MOVABLE(ac_state_t);
+
+struct pattern_hit_t
+{
+  ea_t ea;
+  int pat;
+};
+DECLARE_TYPE_AS_MOVABLE(pattern_hit_t);
+typedef qvector<pattern_hit_t> pattern_hits_t;
+
+//-------------------------------------------------------------------------
+class multi_pattern_searcher_t
+{
+  bin_patterns_t pats;
+  qvector<ac_state_t> states;
+  int root[256];                // dense root transitions, 0 if none
+  size_t maxlen;
+
+  //-------------------------------------------------------------------------
+  int get_edge(int s, uchar c) const
+  {
+    if ( s == 0 )
+      return root[c];
+    const qvector<ac_edge_t> &e = states[s].edges;
+    for ( size_t i = 0; i < e.size(); ++i )
+      if ( e[i].byte == c )
+        return e[i].target;
+    return -1;
+  }
+
+  //-------------------------------------------------------------------------
+  int add_edge(int s, uchar c)
+  {
+    int t = get_edge(s, c);
+    if ( t > 0 )
+      return t;
+    t = int(states.size());
+    states.push_back();
+    if ( s == 0 )
+    {
+      root[c] = t;
+    }
+    else
+    {
+      ac_edge_t &e = states[s].edges.push_back();
+      e.byte = c;
+      e.target = t;
+    }
+    return t;
+  }
+
+  //-------------------------------------------------------------------------
+  // Computes the failure and output links, breadth first
+  void link()
+  {
+    intvec_t queue;
+    for ( int c = 0; c < 256; ++c )
+      if ( root[c] > 0 )
+        queue.push_back(root[c]);
+    for ( size_t qi = 0; qi < queue.size(); ++qi )
+    {
+      int s = queue[qi];
+      for ( size_t i = 0; i < states[s].edges.size(); ++i )
+      {
+        uchar c = states[s].edges[i].byte;
+        int t = states[s].edges[i].target;
+        int f = states[s].fail;
+        int n;
+        while ( (n = get_edge(f, c)) < 0 )
+          f = states[f].fail;
+        states[t].fail = n;
+        states[t].out = states[n].pats.empty() ? states[n].out : n;
+        queue.push_back(t);
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------
+  void verify(
+        pattern_hits_t *hits,
+        const uchar *buf,
+        size_t buflen,
+        size_t report_len,
+        ea_t buf_ea,
+        size_t anchor_end,
+        int s) const
+  {
+    for ( ; s > 0; s = states[s].out )
+    {
+      const intvec_t &sp = states[s].pats;
+      for ( size_t i = 0; i < sp.size(); ++i )
+      {
+        const bin_pattern_t &p = pats[sp[i]];
+        size_t back = p.anchor_off + p.anchor_len;
+        if ( anchor_end < back )
+          continue;
+        size_t start = anchor_end - back;
+        if ( start >= report_len || start + p.bytes.size() > buflen )
+          continue;
+        const uchar *q = buf + start;
+        size_t k;
+        for ( k = 0; k < p.bytes.size(); ++k )
+          if ( (q[k] & p.mask[k]) != p.bytes[k] )
+            break;
+        if ( k == p.bytes.size() )
+        {
+          pattern_hit_t &h = hits->push_back();
+          h.ea = buf_ea + start;
+          h.pat = sp[i];
+        }
+      }
+    }
+  }
+
+public:
+  multi_pattern_searcher_t() : maxlen(0)
+  {
+    memset(root, 0, sizeof(root));
+    states.push_back();
+  }
+
+  //-------------------------------------------------------------------------
+  // Parses a pattern like "55 8B EC ?? 83" or "558BEC??83" ('?' or '??'
+  // is a wildcard byte). Returns false if the pattern is malformed or
+  // has no fixed byte.
+  static bool parse(bin_pattern_t *out, const char *str)
+  {
+    out->bytes.qclear();
+    out->mask.qclear();
+    while ( *str != '\0' )
+    {
+      if ( qisspace(*str) )
+      {
+        ++str;
+        continue;
+      }
+      if ( *str == '?' )
+      {
+        ++str;
+        if ( *str == '?' )
+          ++str;
+        out->bytes.push_back(0);
+        out->mask.push_back(0);
+        continue;
+      }
+      int hi = hexval(str[0]);
+      int lo = hi < 0 ? -1 : hexval(str[1]);
+      if ( lo < 0 )
+        return false;
+      out->bytes.push_back(uchar((hi << 4) | lo));
+      out->mask.push_back(0xFF);
+      str += 2;
+    }
+
+    // pick the longest run of fixed bytes as the anchor
+    out->anchor_off = 0;
+    out->anchor_len = 0;
+    for ( size_t i = 0; i < out->mask.size(); )
+    {
+      size_t j = i;
+      while ( j < out->mask.size() && out->mask[j] != 0 )
+        ++j;
+      if ( j - i > out->anchor_len )
+      {
+        out->anchor_off = i;
+        out->anchor_len = j - i;
+      }
+      i = j + 1;
+    }
+    return out->anchor_len > 0;
+  }
+
+  //-------------------------------------------------------------------------
+  static int hexval(char c)
+  {
+    if ( c >= '0' && c <= '9' )
+      return c - '0';
+    if ( c >= 'a' && c <= 'f' )
+      return c - 'a' + 10;
+    if ( c >= 'A' && c <= 'F' )
+      return c - 'A' + 10;
+    return -1;
+  }
+
+  //-------------------------------------------------------------------------
+  void add(const bin_pattern_t &p)
+  {
+    int id = int(pats.size());
+    pats.push_back(p);
+    maxlen = qmax(maxlen, p.bytes.size());
+    int s = 0;
+    for ( size_t i = 0; i < p.anchor_len; ++i )
+      s = add_edge(s, p.bytes[p.anchor_off + i]);
+    states[s].pats.push_back(id);
+  }
+
+  //-------------------------------------------------------------------------
+  void compile()
+  {
+    link();
+  }
+
+  //-------------------------------------------------------------------------
+  size_t max_pattern_length() const { return maxlen; }
+
+  //-------------------------------------------------------------------------
+  // Reports the patterns that start in [buf, buf+report_len) and end
+  // before buf+buflen
+  void scan(
+        pattern_hits_t *hits,
+        const uchar *buf,
+        size_t buflen,
+        size_t report_len,
+        ea_t buf_ea) const
+  {
+    int s = 0;
+    for ( size_t i = 0; i < buflen; ++i )
+    {
+      if ( s == 0 )
+      {
+        // prefilter: skip the bytes that can't start an anchor
+        while ( i < buflen && root[buf[i]] == 0 )
+          ++i;
+        if ( i == buflen )
+          break;
+      }
+      uchar c = buf[i];
+      int n;
+      while ( (n = get_edge(s, c)) < 0 )
+        s = states[s].fail;
+      s = n;
+      if ( s != 0 )
+        verify(hits, buf, buflen, report_len, buf_ea, i + 1, states[s].pats.empty() ? states[s].out : s);
+    }
+  }
+};
+
+//-------------------------------------------------------------------------
+static int cmp_pattern_hits(const void *a, const void *b)
+{
+  const pattern_hit_t *x = (const pattern_hit_t *)a;
+  const pattern_hit_t *y = (const pattern_hit_t *)b;
+  if ( x->ea != y->ea )
+    return x->ea < y->ea ? -1 : 1;
+  return x->pat - y->pat;
+}
+
+//-------------------------------------------------------------------------
+#define FIND_PATTERNS_WINDOW (1 << 20)
+
+struct find_patterns_job_t : public bytes_snapshot_job_t
+{
+  const multi_pattern_searcher_t *mps;
+  pattern_hits_t hits;
+
+  virtual void run(const volatile bool *cancelled)
+  {
+    if ( !*cancelled )
+      mps->scan(&hits, bytes.begin(), bytes.size(), report_len, ea);
+  }
+};
+
+struct find_patterns_scanner_t : public snapshot_scanner_t
+{
+  const multi_pattern_searcher_t &mps;
+  pattern_hits_t hits;
+
+  find_patterns_scanner_t(const multi_pattern_searcher_t &_mps) : mps(_mps) {}
+  virtual bytes_snapshot_job_t *new_job()
+  {
+    find_patterns_job_t *job = new find_patterns_job_t;
+    job->mps = &mps;
+    return job;
+  }
+  virtual void merge(const bytes_snapshot_job_t &job)
+  {
+    const pattern_hits_t &h = ((const find_patterns_job_t &)job).hits;
+    for ( size_t i = 0; i < h.size(); ++i )
+      hits.push_back(h[i]);
+  }
+  // Consecutive windows overlap by the longest pattern length (minus 1),
+  // so that the hits that straddle them are found
+  bool scan_range(ea_t ea1, ea_t ea2)
+  {
+    return scan(ea1, ea2, FIND_PATTERNS_WINDOW, mps.max_pattern_length() - 1);
+  }
+};
+//</code(py_search)>
+
+//-------------------------------------------------------------------------
+//<inline(py_search)>
+#define FPAT_EXEC_ONLY  0x01    // only search executable segments
+
+/*
+#<pydoc>
+def find_patterns(patterns, flags = 0, ea1 = inf.minEA, ea2 = inf.maxEA):
+    """
+    Search for many binary patterns at once.
+    The search is done natively, in one pass over the database bytes,
+    without holding the GIL, by the native worker threads (see
+    get_worker_count()). It can be cancelled from the wait box, if one
+    is displayed.
+
+    @param patterns: a sequence of patterns like "55 8B EC ?? 83" or
+                     "558BEC??83", where '?' or '??' matches any byte
+    @param flags: combination of FPAT_... constants
+    @param ea1: start address
+    @param ea2: end address
+    @return: a list of (pattern_index, ea) tuples, sorted by address.
+             Raises ValueError if a pattern is malformed or only has wildcards.
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_find_patterns(
+        PyObject *py_patterns,
+        int flags = 0,
+        ea_t ea1 = BADADDR,
+        ea_t ea2 = BADADDR)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( ea1 == BADADDR )
+    ea1 = inf.minEA;
+  if ( ea2 == BADADDR )
+    ea2 = inf.maxEA;
+
+  newref_t py_seq(PySequence_Fast(py_patterns, "Expected a sequence of patterns"));
+  if ( py_seq == NULL )
+    return NULL;
+  multi_pattern_searcher_t mps;
+  Py_ssize_t npats = PySequence_Fast_GET_SIZE(py_seq.o);
+  for ( Py_ssize_t i = 0; i < npats; ++i )
+  {
+    PyObject *py_pat = PySequence_Fast_GET_ITEM(py_seq.o, i);
+    const char *str = PyString_Check(py_pat) ? PyString_AsString(py_pat) : NULL;
+    bin_pattern_t pat;
+    if ( str == NULL || !multi_pattern_searcher_t::parse(&pat, str) )
+    {
+      PyErr_Format(PyExc_ValueError, "Invalid pattern #%d", int(i));
+      return NULL;
+    }
+    mps.add(pat);
+  }
+
+  find_patterns_scanner_t scanner(mps);
+  pattern_hits_t &hits = scanner.hits;
+  bool ok = true;
+  if ( npats > 0 )
+  {
+    Py_BEGIN_ALLOW_THREADS;
+    mps.compile();
+    for ( int i = 0, n = get_segm_qty(); ok && i < n; ++i )
+    {
+      segment_t *seg = getnseg(i);
+      if ( seg == NULL )
+        continue;
+      if ( (flags & FPAT_EXEC_ONLY) != 0 )
+      {
+        bool exec = seg->perm != 0
+                  ? (seg->perm & SEGPERM_EXEC) != 0
+                  : seg->type == SEG_CODE;
+        if ( !exec )
+          continue;
+      }
+      ea_t start = qmax(ea1, seg->startEA);
+      ea_t end = qmin(ea2, seg->endEA);
+      if ( start < end )
+        ok = scanner.scan_range(start, end);
+    }
+    if ( ok )
+      qsort(hits.begin(), hits.size(), sizeof(pattern_hit_t), cmp_pattern_hits);
+    Py_END_ALLOW_THREADS;
+  }
+  if ( !ok )
+  {
+    PyErr_SetString(PyExc_KeyboardInterrupt, "User interrupted");
+    return NULL;
+  }
+
+  PyObject *py_hits = PyList_New(hits.size());
+  if ( py_hits == NULL )
+    return NULL;
+  for ( size_t i = 0; i < hits.size(); ++i )
+    PyList_SET_ITEM(py_hits, i, Py_BuildValue("(i" PY_FMT64 ")", hits[i].pat, pyul_t(hits[i].ea)));
+  return py_hits;
+}
+//</inline(py_search)>
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef __PYWRAPS_STARTUP__
+#define __PYWRAPS_STARTUP__
+
+//------------------------------------------------------------------------
+//<code(py_idaapi)>
+//------------------------------------------------------------------------
+// Startup profile: the time taken by the phases of IDAPython_Init(), and
+// by the NW_INITIDA/NW_OPENIDB callbacks.
+// The phases are recorded before Python is initialized, thus this does
+// not need the GIL: it only runs on the main thread.
+//------------------------------------------------------------------------
+#define S_STARTUP_PROFILE_ENV "IDAPYTHON_STARTUP_PROFILE"
+
+struct startup_phase_t
+{
+  qstring name;
+  uint64 ns;
+};
+DECLARE_TYPE_AS_MOVABLE(startup_phase_t);
+typedef qvector<startup_phase_t> startup_phases_t;
+
+static startup_phases_t startup_phases;
+static uint64 startup_phase_t0 = 0;
+
+//------------------------------------------------------------------------
+// Records the time of a phase. A phase that is recorded again (e.g. the
+// NW_OPENIDB callbacks, for each database) keeps its last time.
+void pywraps_startup_record(const char *name, uint64 ns)
+{
+  for ( size_t i = 0; i < startup_phases.size(); ++i )
+  {
+    if ( startup_phases[i].name == name )
+    {
+      startup_phases[i].ns = ns;
+      return;
+    }
+  }
+  startup_phase_t &ph = startup_phases.push_back();
+  ph.name = name;
+  ph.ns = ns;
+}
+
+//------------------------------------------------------------------------
+// Ends the current phase of IDAPython_Init(), and starts the next one.
+// name == NULL starts the first phase, and forgets the previous profile.
+void pywraps_startup_phase(const char *name)
+{
+  uint64 t = get_nsec_stamp();
+  if ( name == NULL )
+    startup_phases.clear();
+  else
+    pywraps_startup_record(name, t - startup_phase_t0);
+  startup_phase_t0 = t;
+}
+
+//------------------------------------------------------------------------
+// Dumps the profile if the IDAPYTHON_STARTUP_PROFILE environment variable
+// is set: to the output window if its value is "1", to the file it names
+// otherwise.
+void pywraps_startup_dump()
+{
+  char path[QMAXPATH];
+  if ( !qgetenv(S_STARTUP_PROFILE_ENV, path, sizeof(path)) || path[0] == '\0' )
+    return;
+
+  FILE *fp = NULL;
+  if ( !streq(path, "1") )
+  {
+    fp = qfopen(path, "w");
+    if ( fp == NULL )
+    {
+      msg("IDAPython: could not create the startup profile '%s'\n", path);
+      return;
+    }
+  }
+  uint64 total = 0;
+  for ( size_t i = 0; i < startup_phases.size(); ++i )
+  {
+    const startup_phase_t &ph = startup_phases[i];
+    total += ph.ns;
+    if ( fp != NULL )
+      qfprintf(fp, "%s\t%" FMT_64 "u\n", ph.name.c_str(), ph.ns);
+    else
+      msg("IDAPython startup: %-40s %10.3f ms\n", ph.name.c_str(), ph.ns / 1e6);
+  }
+  if ( fp != NULL )
+    qfclose(fp);
+  else
+    msg("IDAPython startup: %-40s %10.3f ms\n", "total", total / 1e6);
+}
+
+//------------------------------------------------------------------------
+// Times a notify_when() callback for the duration of its scope
+class nw_timer_t
+{
+  qstring name;
+  uint64 t0;
+public:
+  nw_timer_t(const char *slot_name, PyObject *py_callable) : t0(0)
+  {
+    if ( slot_name == NULL )
+      return;
+    name = slot_name;
+    name.append(' ');
+    newref_t py_mod(PyObject_GetAttrString(py_callable, "__module__"));
+    newref_t py_name(PyObject_GetAttrString(py_callable, "__name__"));
+    PyErr_Clear();
+    if ( py_mod != NULL && PyString_Check(py_mod.o) )
+      name.cat_sprnt("%s.", PyString_AS_STRING(py_mod.o));
+    name.append(py_name != NULL && PyString_Check(py_name.o)
+              ? PyString_AS_STRING(py_name.o)
+              : Py_TYPE(py_callable)->tp_name);
+    t0 = get_nsec_stamp();
+  }
+  ~nw_timer_t()
+  {
+    if ( t0 != 0 )
+      pywraps_startup_record(name.c_str(), get_nsec_stamp() - t0);
+  }
+};
+//</code(py_idaapi)>
+
+//------------------------------------------------------------------------
+//<inline(py_idaapi)>
+/*
+#<pydoc>
+def get_startup_profile():
+    """
+    Returns the time taken by the IDAPython startup phases, and by the
+    NW_INITIDA and NW_OPENIDB notify_when() callbacks (for the last
+    database opened).
+    Setting the IDAPYTHON_STARTUP_PROFILE environment variable to 1 prints
+    the profile in the output window at startup and after each NW_OPENIDB.
+    Setting it to a path writes it to that file instead, one phase per line.
+    @return: a list of (phase, duration in ns) tuples, in the order
+             the phases ran
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *get_startup_profile()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  newref_t py_list(PyList_New(startup_phases.size()));
+  if ( py_list == NULL )
+    return NULL;
+  for ( size_t i = 0; i < startup_phases.size(); ++i )
+  {
+    const startup_phase_t &ph = startup_phases[i];
+    PyObject *py_ph = Py_BuildValue("(sK)", ph.name.c_str(), (unsigned PY_LONG_LONG)ph.ns);
+    if ( py_ph == NULL )
+      return NULL;
+    PyList_SET_ITEM(py_list.o, i, py_ph);
+  }
+  py_list.incref();
+  return py_list.o;
+}
+//</inline(py_idaapi)>
+
+#endif
@@ -737,11 +737,8 @@ void py_customidamemo_t::on_view_dblclick(const view_mouse_event_t *event)
 void py_customidamemo_t::on_view_curpos()
 {
   CHK_EVT(GRBASE_HAVE_VIEW_CURPOS);
-  pycall_res_t result(
-          PyObject_CallMethod(
-                  self.o,
-                  (char *)S_ON_VIEW_CURPOS,
-                  NULL));
+  static py_method_t on_view_curpos_m(S_ON_VIEW_CURPOS);
+  pycall_res_t result(on_view_curpos_m.call(self.o, NULL));
 }
 
 //-------------------------------------------------------------------------
@@ -796,22 +793,25 @@ void py_customidamemo_t::on_view_mouse_over(const view_mouse_event_t *event)
 
   int icode;
   ref_t tuple = build_current_graph_item_tuple(&icode, event);
+  static py_method_t on_view_mouse_over_m(S_ON_VIEW_MOUSE_OVER);
+  newref_t py_x(PyInt_FromLong(event->x));
+  newref_t py_y(PyInt_FromLong(event->y));
+  newref_t py_state(PyInt_FromLong(event->state));
+  newref_t py_icode(PyInt_FromLong(icode));
   if ( ovmo_num_args == 7 )
   {
-    PyObject *rpos = build_renderer_pos_swig_proxy(event);
-    pycall_res_t result(PyObject_CallMethod(
+    newref_t rpos(build_renderer_pos_swig_proxy(event));
+    pycall_res_t result(on_view_mouse_over_m.call(
                             self.o,
-                            (char *)S_ON_VIEW_MOUSE_OVER,
-                            "iiiiOO",
-                            event->x, event->y, event->state, icode, tuple.o, rpos));
+                            py_x.o, py_y.o, py_state.o, py_icode.o, tuple.o, rpos.o,
+                            NULL));
   }
   else
   {
-    pycall_res_t result(PyObject_CallMethod(
+    pycall_res_t result(on_view_mouse_over_m.call(
                             self.o,
-                            (char *)S_ON_VIEW_MOUSE_OVER,
-                            "iiiiO",
-                            event->x, event->y, event->state, icode, tuple.o));
+                            py_x.o, py_y.o, py_state.o, py_icode.o, tuple.o,
+                            NULL));
   }
 }
 
@@ -826,12 +826,16 @@ void py_customidamemo_t::on_view_mouse_moved(const view_mouse_event_t *event)
   ref_t tuple = build_current_graph_item_tuple(&icode, event);
   if ( ovmm_num_args == 7 )
   {
-    PyObject *rpos = build_renderer_pos_swig_proxy(event);
-    pycall_res_t result(PyObject_CallMethod(
+    static py_method_t on_view_mouse_moved_m(S_ON_VIEW_MOUSE_MOVED);
+    newref_t py_x(PyInt_FromLong(event->x));
+    newref_t py_y(PyInt_FromLong(event->y));
+    newref_t py_state(PyInt_FromLong(event->state));
+    newref_t py_icode(PyInt_FromLong(icode));
+    newref_t rpos(build_renderer_pos_swig_proxy(event));
+    pycall_res_t result(on_view_mouse_moved_m.call(
                             self.o,
-                            (char *)S_ON_VIEW_MOUSE_MOVED,
-                            "iiiiOO",
-                            event->x, event->y, event->state, icode, tuple.o, rpos));
+                            py_x.o, py_y.o, py_state.o, py_icode.o, tuple.o, rpos.o,
+                            NULL));
   }
 }
 
@@ -0,0 +1,218 @@
+#ifndef __PYWRAPS_WORKERS__
+#define __PYWRAPS_WORKERS__
+
+//------------------------------------------------------------------------
+//<code(py_idaapi)>
+#ifdef __NT__
+#include <windows.h>  // GetSystemInfo()
+#endif
+//------------------------------------------------------------------------
+// A small pool of native worker threads, for read-only kernels that
+// crunch bytes already copied out of the database (the kernel itself must
+// only be called from the main thread). Jobs never touch Python objects.
+//------------------------------------------------------------------------
+struct worker_job_t
+{
+  virtual ~worker_job_t() {}
+  // Runs on a worker thread. Should return early once '*cancelled' is set.
+  virtual void run(const volatile bool *cancelled) = 0;
+};
+typedef qvector<worker_job_t *> worker_jobs_t;
+
+// Called on the main thread while waiting for the jobs.
+// Returns false to cancel the remaining jobs.
+typedef bool idaapi worker_progress_t(size_t ndone, size_t total, void *ud);
+
+//------------------------------------------------------------------------
+class worker_pool_t
+{
+  qvector<qthread_t> threads;
+  qmutex_t lock;
+  qsemaphore_t has_job;         // posted once per queued job (or per thread, on stop)
+  qsemaphore_t job_done;        // posted once per finished job
+  worker_jobs_t queue;
+  size_t qhead;
+  volatile bool stopping;
+  volatile bool cancelled;
+
+  //------------------------------------------------------------------------
+  static int idaapi thread_cb(void *ud)
+  {
+    worker_pool_t *pool = (worker_pool_t *)ud;
+    while ( qsem_wait(pool->has_job, -1) && !pool->stopping )
+    {
+      qmutex_lock(pool->lock);
+      worker_job_t *job = pool->queue[pool->qhead++];
+      qmutex_unlock(pool->lock);
+      job->run(&pool->cancelled);
+      qsem_post(pool->job_done);
+    }
+    return 0;
+  }
+
+  //------------------------------------------------------------------------
+  static int get_cpu_count()
+  {
+#ifdef __NT__
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int n = int(si.dwNumberOfProcessors);
+#else
+    int n = int(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    return qmax(n, 1);
+  }
+
+public:
+  worker_pool_t()
+    : lock(NULL), has_job(NULL), job_done(NULL), qhead(0),
+      stopping(false), cancelled(false) {}
+
+  //------------------------------------------------------------------------
+  // Starts one thread per CPU but one (the main thread has enough to do)
+  bool start()
+  {
+    if ( lock != NULL )
+      return true;
+    lock = qmutex_create();
+    has_job = qsem_create(NULL, 0);
+    job_done = qsem_create(NULL, 0);
+    if ( lock == NULL || has_job == NULL || job_done == NULL )
+    {
+      stop();
+      return false;
+    }
+    stopping = false;
+    int n = qmax(get_cpu_count() - 1, 1);
+    for ( int i = 0; i < n; ++i )
+    {
+      qthread_t t = qthread_create(thread_cb, this);
+      if ( t == NULL )
+        break;
+      threads.push_back(t);
+    }
+    return true;
+  }
+
+  //------------------------------------------------------------------------
+  void stop()
+  {
+    stopping = true;
+    for ( size_t i = 0; i < threads.size(); ++i )
+      qsem_post(has_job);
+    for ( size_t i = 0; i < threads.size(); ++i )
+    {
+      qthread_join(threads[i]);
+      qthread_free(threads[i]);
+    }
+    threads.clear();
+    if ( job_done != NULL )
+      qsem_free(job_done);
+    if ( has_job != NULL )
+      qsem_free(has_job);
+    if ( lock != NULL )
+      qmutex_free(lock);
+    job_done = has_job = NULL;
+    lock = NULL;
+  }
+
+  //------------------------------------------------------------------------
+  size_t size() const { return threads.size(); }
+
+  //------------------------------------------------------------------------
+  // Runs the jobs and waits for them. Must be called from the main thread,
+  // without the GIL. If 'progress' is NULL, wasBreak() is used to cancel.
+  // Returns false if the jobs were cancelled.
+  bool run(const worker_jobs_t &jobs, worker_progress_t *progress = NULL, void *ud = NULL)
+  {
+    cancelled = false;
+    if ( threads.empty() )
+    {
+      // No pool: run everything here
+      for ( size_t i = 0; i < jobs.size() && !cancelled; ++i )
+      {
+        jobs[i]->run(&cancelled);
+        if ( progress != NULL ? !progress(i + 1, jobs.size(), ud) : wasBreak() )
+          cancelled = true;
+      }
+      return !cancelled;
+    }
+
+    qmutex_lock(lock);
+    queue = jobs;
+    qhead = 0;
+    qmutex_unlock(lock);
+    for ( size_t i = 0; i < jobs.size(); ++i )
+      qsem_post(has_job);
+
+    size_t ndone = 0;
+    while ( ndone < jobs.size() )
+    {
+      if ( qsem_wait(job_done, 100) )
+        ++ndone;
+      if ( !cancelled && (progress != NULL ? !progress(ndone, jobs.size(), ud) : wasBreak()) )
+        cancelled = true;
+    }
+    queue.clear();
+    return !cancelled;
+  }
+};
+
+// NULL if it could not be started
+static worker_pool_t *worker_pool = NULL;
+
+//------------------------------------------------------------------------
+bool pywraps_workers_init()
+{
+  if ( worker_pool != NULL )
+    return true;
+  worker_pool = new worker_pool_t();
+  if ( !worker_pool->start() )
+  {
+    delete worker_pool;
+    worker_pool = NULL;
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------
+void pywraps_workers_term()
+{
+  if ( worker_pool == NULL )
+    return;
+  worker_pool->stop();
+  delete worker_pool;
+  worker_pool = NULL;
+}
+
+//------------------------------------------------------------------------
+// Runs the jobs on the pool, or on the calling thread if there is no pool.
+// Must be called from the main thread, without the GIL.
+static bool run_worker_jobs(const worker_jobs_t &jobs)
+{
+  static worker_pool_t inline_pool;
+  return (worker_pool != NULL ? worker_pool : &inline_pool)->run(jobs);
+}
+//</code(py_idaapi)>
+
+//------------------------------------------------------------------------
+//<inline(py_idaapi)>
+/*
+#<pydoc>
+def get_worker_count():
+    """
+    Returns the number of native worker threads used by the scanning
+    functions (find_patterns(), get_block_entropy(), ...).
+    0 means that they run on the main thread.
+    """
+    pass
+#</pydoc>
+*/
+static size_t get_worker_count()
+{
+  return worker_pool == NULL ? 0 : worker_pool->size();
+}
+//</inline(py_idaapi)>
+
+#endif
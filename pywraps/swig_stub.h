@@ -17,6 +17,18 @@ namespace Swig
       return "NULL";
     }
   };
+
+  // The driver's classes are never directors: get_director_self()
+  // always gets NULL from its dynamic_cast<>
+  class Director
+  {
+  public:
+    virtual ~Director() {}
+    PyObject *swig_get_self() const
+    {
+      return NULL;
+    }
+  };
 }
 
 #define SWIG_RUNTIME_VERSION "4"
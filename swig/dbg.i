@@ -236,6 +236,7 @@ int idaapi DBG_Callback(void *ud, int notification_code, va_list va)
   PYW_GIL_GET;
 
   class DBG_Hooks *proxy = (class DBG_Hooks *)ud;
+  hook_timer_t timer("DBG_Hooks", notification_code, proxy);
   debug_event_t *event;
   int code = 0;
 
@@ -3,6 +3,43 @@
 // * http://stackoverflow.com/questions/1576737/releasing-python-gil-in-c-code
 // * http://matt.eifelle.com/2007/11/23/enabling-thread-support-in-swig-and-python/
 %nothread; // We don't want SWIG to release the GIL for *every* IDA API call.
+
+// ...but we do for the calls that can run for seconds or minutes, so that
+// the other Python threads keep running meanwhile. The Python callbacks
+// the kernel calls in the meantime (hooks, IDC functions, ...) take the
+// GIL back with gil_lock_t (PYW_GIL_GET), or with the SWIG directors.
+// Only pure kernel calls can go here: the wrapped function itself must
+// not touch Python objects. dbg.hpp is wholly released, see dbg.i.
+// auto.hpp: run the auto-analysis
+%thread autoWait;
+%thread analyze_area;
+%thread plan_and_wait;
+%thread reanalyze_callers;
+// bytes.hpp, search.hpp: scan the whole database in the worst case
+%thread find_binary;
+%thread find_text;
+%thread find_imm;
+%thread find_void;
+%thread find_code;
+%thread find_data;
+%thread find_unknown;
+%thread find_defined;
+%thread find_suspop;
+%thread find_error;
+%thread find_notype;
+// loader.hpp: write files
+%thread gen_file;
+%thread save_database;
+%thread save_database_ex;
+// gdl.hpp: build and display graphs
+%thread gen_flow_graph;
+%thread gen_simple_call_chart;
+%thread gen_complex_call_chart;
+// kernwin.i: generates the disassembly of a range
+%thread py_gen_disasm_text;
+// hexrays.i: decompile
+%thread _decompile;
+%thread decompile_many;
 // Suppress 'previous definition of XX' warnings
 #pragma SWIG nowarn=302
 // and others...
@@ -121,6 +158,8 @@ static PyObject *type##_get_clink_ptr(PyObject *self)
 
 %{
 #include <Python.h>
+#include <compile.h>
+#include <frameobject.h>
 
 #ifdef HAVE_SSIZE_T
 #define _SSIZE_T_DEFINED 1
@@ -429,6 +468,24 @@ static error_t idaapi py_idc_opaque_dtor(
   return eOk;
 }
 
+//-------------------------------------------------------------------------
+// Formats the attribute name of the IDC object element 'idx' (its decimal
+// representation, as str(idx)) at the end of 'buf', and returns it.
+// 'buf' must have CVT_INDEX_BUFSIZE bytes.
+#define CVT_INDEX_BUFSIZE 24
+static const char *cvt_index_attr_name(char *buf, Py_ssize_t idx)
+{
+  char *p = buf + CVT_INDEX_BUFSIZE;
+  *--p = '\0';
+  size_t n = size_t(idx);
+  do
+  {
+    *--p = char('0' + n % 10);
+    n /= 10;
+  } while ( n != 0 );
+  return p;
+}
+
 //-------------------------------------------------------------------------
 // Converts a Python variable into an IDC variable
 // This function returns on one CIP_XXXX
@@ -477,37 +534,55 @@ int pyvar_to_idcvar(
     // Create the object
     VarObject(idc_var);
 
-    // Determine list size and type
-    bool is_seq = !PyList_CheckExact(py_var.o);
-    Py_ssize_t size = is_seq ? PySequence_Size(py_var.o) : PyList_Size(py_var.o);
+    // Lists and tuples give their items directly,
+    // the other sequences go through the sequence protocol
+    bool is_list = PyList_CheckExact(py_var.o);
+    bool is_tuple = !is_list && PyTuple_CheckExact(py_var.o);
+    Py_ssize_t size = is_list  ? PyList_GET_SIZE(py_var.o)
+                    : is_tuple ? PyTuple_GET_SIZE(py_var.o)
+                    :            PySequence_Size(py_var.o);
     bool ok = true;
-    qstring attr_name;
+    char buf[CVT_INDEX_BUFSIZE];
 
     // Convert each item
     for ( Py_ssize_t i=0; i<size; i++ )
     {
-      // Get the item
+      // Get the item (converting an item may run Python code
+      // that changes the list: hold a reference to it)
       ref_t py_item;
-      if ( is_seq )
-        py_item = newref_t(PySequence_GetItem(py_var.o, i));
+      if ( is_list )
+      {
+        py_item = borref_t(PyList_GET_ITEM(py_var.o, i));
+      }
+      else if ( is_tuple )
+      {
+        py_item = borref_t(PyTuple_GET_ITEM(py_var.o, i));
+      }
       else
-        py_item = borref_t(PyList_GetItem(py_var.o, i));
+      {
+        py_item = newref_t(PySequence_GetItem(py_var.o, i));
+        if ( py_item == NULL )
+        {
+          ok = false;
+          break;
+        }
+      }
 
       // Convert the item into an IDC variable
       idc_value_t v;
       ok = pyvar_to_idcvar(py_item, &v, gvar_sn) >= CIP_OK;
-      if ( ok )
-      {
-        // Form the attribute name
-        newref_t py_int(PyInt_FromSsize_t(i));
-        ok = PyW_ObjectToString(py_int.o, &attr_name);
-        if ( !ok )
-          break;
-        // Store the attribute
-        VarSetAttr(idc_var, attr_name.c_str(), &v);
-      }
       if ( !ok )
         break;
+      // Fail if the list changed, as for the dictionaries below
+      if ( is_list && PyList_GET_SIZE(py_var.o) != size )
+      {
+        PyErr_SetString(PyExc_RuntimeError, "list changed size during conversion");
+        ok = false;
+        break;
+      }
+
+      // Store the attribute, named after the index
+      VarSetAttr(idc_var, cvt_index_attr_name(buf, i), &v);
     }
     return ok ? CIP_OK : CIP_FAILED;
   }
@@ -517,35 +592,54 @@ int pyvar_to_idcvar(
     // Create an empty IDC object
     VarObject(idc_var);
 
-    // Get the dict.items() list
-    newref_t py_items(PyDict_Items(py_var.o));
-
-    // Get the size of the list
-    qstring key_name;
+    qstring key_str;
+    char buf[CVT_INDEX_BUFSIZE];
     bool ok = true;
-    Py_ssize_t size = PySequence_Size(py_items.o);
-    for ( Py_ssize_t i=0; i<size; i++ )
+    // Converting a key or a value may run Python code that changes the
+    // dictionary, and PyDict_Next() would then skip or repeat entries:
+    // fail in that case, as Python does when iterating over a dictionary
+    PyDictObject *py_dict = (PyDictObject *)py_var.o;
+    Py_ssize_t dict_size = PyDict_Size(py_var.o);
+    Py_ssize_t dict_fill = py_dict->ma_fill;
+    Py_ssize_t pos = 0;
+    PyObject *key, *val;
+    while ( PyDict_Next(py_var.o, &pos, &key, &val) )
     {
-      // Get item[i] -> (key, value)
-      PyObject *py_item = PyList_GetItem(py_items.o, i);
-
-      // Extract key/value
-      newref_t key(PySequence_GetItem(py_item, 0));
-      newref_t val(PySequence_GetItem(py_item, 1));
+      // Hold references to the key and value, in case the dictionary
+      // drops them while they are converted
+      borref_t py_key(key);
+      borref_t py_val(val);
 
       // Get key's string representation
-      PyW_ObjectToString(key.o, &key_name);
+      const char *key_name;
+      if ( PyString_CheckExact(key) )
+      {
+        key_name = PyString_AS_STRING(key);
+      }
+      else if ( PyInt_CheckExact(key) && PyInt_AS_LONG(key) >= 0 )
+      {
+        key_name = cvt_index_attr_name(buf, PyInt_AS_LONG(key));
+      }
+      else
+      {
+        PyW_ObjectToString(key, &key_str);
+        key_name = key_str.c_str();
+      }
 
       // Convert the attribute into an IDC value
       idc_value_t v;
-      ok = pyvar_to_idcvar(val, &v, gvar_sn) >= CIP_OK;
-      if ( ok )
-      {
-        // Store the attribute
-        VarSetAttr(idc_var, key_name.c_str(), &v);
-      }
+      ok = pyvar_to_idcvar(py_val, &v, gvar_sn) >= CIP_OK;
       if ( !ok )
         break;
+      if ( PyDict_Size(py_var.o) != dict_size || py_dict->ma_fill != dict_fill )
+      {
+        PyErr_SetString(PyExc_RuntimeError, "dictionary changed size during conversion");
+        ok = false;
+        break;
+      }
+
+      // Store the attribute
+      VarSetAttr(idc_var, key_name, &v);
     }
     return ok ? CIP_OK : CIP_FAILED;
   }
@@ -1007,6 +1101,9 @@ static const char S_PY_IDAAPI_MODNAME[]      = S_IDAAPI_MODNAME;
 static ref_t py_cvt_helper_module;
 static bool pywraps_initialized = false;
 
+// See gil_lock_t
+PYW_THREAD_LOCAL gil_tls_t gil_tls;
+
 //---------------------------------------------------------------------------
 // Context structure used by add|del_menu_item()
 struct py_add_del_menu_item_ctx
@@ -1031,6 +1128,164 @@ struct py_timer_ctx_t
   PyObject *pycallback;
 };
 
+//---------------------------------------------------------------------------
+// An event dispatched by a hook class (IDB_Hooks, IDP_Hooks), and the
+// Python method that handles it
+struct hook_event_t
+{
+  int code;             // notification code
+  const char *method;   // name of the method
+  int defret;           // what the method of the base class returns
+};
+
+//------------------------------------------------------------------------
+static int find_hook_event(const hook_event_t *events, size_t nevents, int code)
+{
+  for ( size_t i = 0; i < nevents; ++i )
+    if ( events[i].code == code )
+      return int(i);
+  return -1;
+}
+
+//------------------------------------------------------------------------
+// Python side of a SWIG director, or NULL if 'obj' is not a director
+// (i.e., it was created from the SWIG proxy class itself)
+template <class T>
+static PyObject *get_director_self(T *obj)
+{
+  Swig::Director *d = dynamic_cast<Swig::Director *>(obj);
+  return d == NULL ? NULL : d->swig_get_self();
+}
+
+//------------------------------------------------------------------------
+// Returns the bitmask of the events (at most 64) whose method is defined
+// by the Python object 'self' itself, or by a class that comes before the
+// 'base_clsname' SWIG proxy class in its MRO.
+static uint64 get_overridden_events(
+        PyObject *self,
+        const char *base_clsname,
+        const hook_event_t *events,
+        size_t nevents)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( self == NULL )
+    return 0; // not subclassed: nothing to dispatch
+
+  ref_t py_base(PyW_TryGetAttrString(py_cvt_helper_module.o, base_clsname));
+  PyObject *mro = Py_TYPE(self)->tp_mro;
+  if ( py_base == NULL || mro == NULL || !PyTuple_Check(mro) )
+    return ~uint64(0); // can't tell: dispatch everything
+
+  PyObject **dictptr = _PyObject_GetDictPtr(self);
+  uint64 mask = 0;
+  for ( size_t i = 0; i < nevents && i < 64; ++i )
+  {
+    const char *method = events[i].method;
+    bool found = dictptr != NULL
+              && *dictptr != NULL
+              && PyDict_GetItemString(*dictptr, method) != NULL;
+    for ( Py_ssize_t j = 0; !found && j < PyTuple_GET_SIZE(mro); ++j )
+    {
+      PyObject *cls = PyTuple_GET_ITEM(mro, j);
+      if ( cls == py_base.o )
+        break;
+      PyObject *dict = NULL;
+      if ( PyType_Check(cls) )
+        dict = ((PyTypeObject *)cls)->tp_dict;
+      else if ( PyClass_Check(cls) )
+        dict = ((PyClassObject *)cls)->cl_dict;
+      found = dict != NULL && PyDict_GetItemString(dict, method) != NULL;
+    }
+    if ( found )
+      mask |= uint64(1) << i;
+  }
+  return mask;
+}
+
+//------------------------------------------------------------------------
+// A method that is called back often (Choose2.OnGetLine, ...).
+// The name is interned once, and call() resolves it through the type
+// attribute cache (that Python invalidates whenever a class attribute is
+// assigned) and the instance dictionary. A plain function is then called
+// directly: no lookup by name, no bound method, no format string parsing.
+// No bound method is kept around, as it would keep the object alive.
+class py_method_t
+{
+  const char *name;
+  PyObject *py_name;    // interned; never released
+
+public:
+  explicit py_method_t(const char *_name) : name(_name), py_name(NULL) {}
+
+  //------------------------------------------------------------------------
+  // Calls self.<name>(...) with a NULL-terminated list of arguments.
+  // Returns a new reference, or NULL if an exception was raised.
+  PyObject *call(PyObject *self, ...)
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    PyObject *args[8];
+    int nargs = 1;
+    va_list va;
+    va_start(va, self);
+    for ( PyObject *arg; nargs < int(qnumber(args)) && (arg = va_arg(va, PyObject *)) != NULL; )
+      args[nargs++] = arg;
+    va_end(va);
+
+    if ( py_name == NULL )
+    {
+      py_name = PyString_InternFromString(name);
+      if ( py_name == NULL )
+        return NULL;
+    }
+
+    // What does 'self.<name>' resolve to?
+    PyObject *func = NULL;
+    bool pass_self = false;
+    if ( !PyInstance_Check(self) )
+    {
+      PyObject *cls_attr = _PyType_Lookup(Py_TYPE(self), py_name);
+      PyObject *inst_attr = NULL;
+      PyObject **dictptr = _PyObject_GetDictPtr(self);
+      if ( dictptr != NULL && *dictptr != NULL )
+        inst_attr = PyDict_GetItem(*dictptr, py_name);
+      if ( inst_attr != NULL && cls_attr == NULL )
+      {
+        func = inst_attr;
+      }
+      else if ( inst_attr == NULL && cls_attr != NULL && PyFunction_Check(cls_attr) )
+      {
+        func = cls_attr;
+        pass_self = true;
+      }
+    }
+    // The call may release the attribute (e.g., if it reassigns it)
+    ref_t py_func;
+    if ( func != NULL )
+    {
+      py_func = borref_t(func);
+    }
+    else
+    {
+      // Anything else (descriptors, classic classes, ...): the slow way
+      py_func = newref_t(PyObject_GetAttr(self, py_name));
+      if ( py_func == NULL )
+        return NULL;
+    }
+
+    int first = pass_self ? 0 : 1;
+    args[0] = self;
+    newref_t py_args(PyTuple_New(nargs - first));
+    if ( py_args == NULL )
+      return NULL;
+    for ( int i = first; i < nargs; ++i )
+    {
+      Py_INCREF(args[i]);
+      PyTuple_SET_ITEM(py_args.o, i - first, args[i]);
+    }
+    return PyObject_Call(py_func.o, py_args.o, NULL);
+  }
+};
+
 //------------------------------------------------------------------------
 // check if we have a file which is known to be executed automatically
 // by SWIG or Python runtime
@@ -1550,6 +1805,123 @@ void *pyobj_get_clink(PyObject *pyobj)
 
 
 
+//------------------------------------------------------------------------
+// Startup profile: the time taken by the phases of IDAPython_Init(), and
+// by the NW_INITIDA/NW_OPENIDB callbacks.
+// The phases are recorded before Python is initialized, thus this does
+// not need the GIL: it only runs on the main thread.
+//------------------------------------------------------------------------
+#define S_STARTUP_PROFILE_ENV "IDAPYTHON_STARTUP_PROFILE"
+
+struct startup_phase_t
+{
+  qstring name;
+  uint64 ns;
+};
+DECLARE_TYPE_AS_MOVABLE(startup_phase_t);
+typedef qvector<startup_phase_t> startup_phases_t;
+
+static startup_phases_t startup_phases;
+static uint64 startup_phase_t0 = 0;
+
+//------------------------------------------------------------------------
+// Records the time of a phase. A phase that is recorded again (e.g. the
+// NW_OPENIDB callbacks, for each database) keeps its last time.
+void pywraps_startup_record(const char *name, uint64 ns)
+{
+  for ( size_t i = 0; i < startup_phases.size(); ++i )
+  {
+    if ( startup_phases[i].name == name )
+    {
+      startup_phases[i].ns = ns;
+      return;
+    }
+  }
+  startup_phase_t &ph = startup_phases.push_back();
+  ph.name = name;
+  ph.ns = ns;
+}
+
+//------------------------------------------------------------------------
+// Ends the current phase of IDAPython_Init(), and starts the next one.
+// name == NULL starts the first phase, and forgets the previous profile.
+void pywraps_startup_phase(const char *name)
+{
+  uint64 t = get_nsec_stamp();
+  if ( name == NULL )
+    startup_phases.clear();
+  else
+    pywraps_startup_record(name, t - startup_phase_t0);
+  startup_phase_t0 = t;
+}
+
+//------------------------------------------------------------------------
+// Dumps the profile if the IDAPYTHON_STARTUP_PROFILE environment variable
+// is set: to the output window if its value is "1", to the file it names
+// otherwise.
+void pywraps_startup_dump()
+{
+  char path[QMAXPATH];
+  if ( !qgetenv(S_STARTUP_PROFILE_ENV, path, sizeof(path)) || path[0] == '\0' )
+    return;
+
+  FILE *fp = NULL;
+  if ( !streq(path, "1") )
+  {
+    fp = qfopen(path, "w");
+    if ( fp == NULL )
+    {
+      msg("IDAPython: could not create the startup profile '%s'\n", path);
+      return;
+    }
+  }
+  uint64 total = 0;
+  for ( size_t i = 0; i < startup_phases.size(); ++i )
+  {
+    const startup_phase_t &ph = startup_phases[i];
+    total += ph.ns;
+    if ( fp != NULL )
+      qfprintf(fp, "%s\t%" FMT_64 "u\n", ph.name.c_str(), ph.ns);
+    else
+      msg("IDAPython startup: %-40s %10.3f ms\n", ph.name.c_str(), ph.ns / 1e6);
+  }
+  if ( fp != NULL )
+    qfclose(fp);
+  else
+    msg("IDAPython startup: %-40s %10.3f ms\n", "total", total / 1e6);
+}
+
+//------------------------------------------------------------------------
+// Times a notify_when() callback for the duration of its scope
+class nw_timer_t
+{
+  qstring name;
+  uint64 t0;
+public:
+  nw_timer_t(const char *slot_name, PyObject *py_callable) : t0(0)
+  {
+    if ( slot_name == NULL )
+      return;
+    name = slot_name;
+    name.append(' ');
+    newref_t py_mod(PyObject_GetAttrString(py_callable, "__module__"));
+    newref_t py_name(PyObject_GetAttrString(py_callable, "__name__"));
+    PyErr_Clear();
+    if ( py_mod != NULL && PyString_Check(py_mod.o) )
+      name.cat_sprnt("%s.", PyString_AS_STRING(py_mod.o));
+    name.append(py_name != NULL && PyString_Check(py_name.o)
+              ? PyString_AS_STRING(py_name.o)
+              : Py_TYPE(py_callable)->tp_name);
+    t0 = get_nsec_stamp();
+  }
+  ~nw_timer_t()
+  {
+    if ( t0 != 0 )
+      pywraps_startup_record(name.c_str(), get_nsec_stamp() - t0);
+  }
+};
+
+
 //------------------------------------------------------------------------
 
 //------------------------------------------------------------------------
@@ -1710,11 +2082,17 @@ public:
     in_notify = true;
     int old = slot == NW_OPENIDB_SLOT ? va_arg(va, int) : 0;
 
+    // The NW_INITIDA and NW_OPENIDB callbacks are part of the startup profile
+    const char *profile_name = slot == NW_INITIDA_SLOT ? "NW_INITIDA"
+                             : slot == NW_OPENIDB_SLOT ? "NW_OPENIDB"
+                             : NULL;
     {
       for (ref_vec_t::iterator it = table[slot].begin(), it_end = table[slot].end();
            it != it_end;
            ++it)
       {
+        nw_timer_t timer(profile_name, it->o);
+
         // Form the notification code
         newref_t py_code(PyInt_FromLong(1 << slot));
         ref_t py_result;
@@ -1744,6 +2122,9 @@ public:
     }
     in_notify = false;
 
+    if ( slot == NW_OPENIDB_SLOT && !table[slot].empty() )
+      pywraps_startup_dump();
+
     // Process any delayed notify_when() calls that
     if ( !delayed_notify_when_list.empty() )
     {
@@ -1821,82 +2202,722 @@ bool pywraps_nw_term()
   return true;
 }
 
-//</code(py_idaapi)>
-%}
-
-// Do not create separate wrappers for default arguments
-%feature("compactdefaultargs");
 
-%constant ea_t BADADDR = ea_t(-1);
-%constant sel_t BADSEL = sel_t(-1);
-%constant nodeidx_t BADNODE = nodeidx_t(-1);
 
-// Help SWIG to figure out the ulonglong type
-#ifdef SWIGWIN
-typedef unsigned __int64 ulonglong;
-typedef          __int64 longlong;
-#else
-typedef unsigned long long ulonglong;
-typedef          long long longlong;
+#ifdef __NT__
+#include <windows.h>  // GetSystemInfo()
 #endif
+//------------------------------------------------------------------------
+// A small pool of native worker threads, for read-only kernels that
+// crunch bytes already copied out of the database (the kernel itself must
+// only be called from the main thread). Jobs never touch Python objects.
+//------------------------------------------------------------------------
+struct worker_job_t
+{
+  virtual ~worker_job_t() {}
+  // Runs on a worker thread. Should return early once '*cancelled' is set.
+  virtual void run(const volatile bool *cancelled) = 0;
+};
+typedef qvector<worker_job_t *> worker_jobs_t;
 
-typedef int error_t;
+// Called on the main thread while waiting for the jobs.
+// Returns false to cancel the remaining jobs.
+typedef bool idaapi worker_progress_t(size_t ndone, size_t total, void *ud);
 
-%include "typemaps.i"
+//------------------------------------------------------------------------
+class worker_pool_t
+{
+  qvector<qthread_t> threads;
+  qmutex_t lock;
+  qsemaphore_t has_job;         // posted once per queued job (or per thread, on stop)
+  qsemaphore_t job_done;        // posted once per finished job
+  worker_jobs_t queue;
+  size_t qhead;
+  volatile bool stopping;
+  volatile bool cancelled;
 
-%include "cstring.i"
-%include "carrays.i"
-%include "cpointer.i"
+  //------------------------------------------------------------------------
+  static int idaapi thread_cb(void *ud)
+  {
+    worker_pool_t *pool = (worker_pool_t *)ud;
+    while ( qsem_wait(pool->has_job, -1) && !pool->stopping )
+    {
+      qmutex_lock(pool->lock);
+      worker_job_t *job = pool->queue[pool->qhead++];
+      qmutex_unlock(pool->lock);
+      job->run(&pool->cancelled);
+      qsem_post(pool->job_done);
+    }
+    return 0;
+  }
 
-%include "typeconv.i"
+  //------------------------------------------------------------------------
+  static int get_cpu_count()
+  {
+#ifdef __NT__
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int n = int(si.dwNumberOfProcessors);
+#else
+    int n = int(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    return qmax(n, 1);
+  }
 
-%pythoncode %{
-#<pycode(py_idaapi)>
+public:
+  worker_pool_t()
+    : lock(NULL), has_job(NULL), job_done(NULL), qhead(0),
+      stopping(false), cancelled(false) {}
 
-import struct
-import traceback
-import os
-import sys
-import bisect
-import __builtin__
-import imp
+  //------------------------------------------------------------------------
+  // Starts one thread per CPU but one (the main thread has enough to do)
+  bool start()
+  {
+    if ( lock != NULL )
+      return true;
+    lock = qmutex_create();
+    has_job = qsem_create(NULL, 0);
+    job_done = qsem_create(NULL, 0);
+    if ( lock == NULL || has_job == NULL || job_done == NULL )
+    {
+      stop();
+      return false;
+    }
+    stopping = false;
+    int n = qmax(get_cpu_count() - 1, 1);
+    for ( int i = 0; i < n; ++i )
+    {
+      qthread_t t = qthread_create(thread_cb, this);
+      if ( t == NULL )
+        break;
+      threads.push_back(t);
+    }
+    return true;
+  }
 
-def require(modulename, package=None):
-    """
-    Load, or reload a module.
+  //------------------------------------------------------------------------
+  void stop()
+  {
+    stopping = true;
+    for ( size_t i = 0; i < threads.size(); ++i )
+      qsem_post(has_job);
+    for ( size_t i = 0; i < threads.size(); ++i )
+    {
+      qthread_join(threads[i]);
+      qthread_free(threads[i]);
+    }
+    threads.clear();
+    if ( job_done != NULL )
+      qsem_free(job_done);
+    if ( has_job != NULL )
+      qsem_free(has_job);
+    if ( lock != NULL )
+      qmutex_free(lock);
+    job_done = has_job = NULL;
+    lock = NULL;
+  }
 
-    When under heavy development, a user's tool might consist of multiple
-    modules. If those are imported using the standard 'import' mechanism,
-    there is no guarantee that the Python implementation will re-read
-    and re-evaluate the module's Python code. In fact, it usually doesn't.
-    What should be done instead is 'reload()'-ing that module.
+  //------------------------------------------------------------------------
+  size_t size() const { return threads.size(); }
 
-    This is a simple helper function that will do just that: In case the
-    module doesn't exist, it 'import's it, and if it does exist,
-    'reload()'s it.
+  //------------------------------------------------------------------------
+  // Runs the jobs and waits for them. Must be called from the main thread,
+  // without the GIL. If 'progress' is NULL, wasBreak() is used to cancel.
+  // Returns false if the jobs were cancelled.
+  bool run(const worker_jobs_t &jobs, worker_progress_t *progress = NULL, void *ud = NULL)
+  {
+    cancelled = false;
+    if ( threads.empty() )
+    {
+      // No pool: run everything here
+      for ( size_t i = 0; i < jobs.size() && !cancelled; ++i )
+      {
+        jobs[i]->run(&cancelled);
+        if ( progress != NULL ? !progress(i + 1, jobs.size(), ud) : wasBreak() )
+          cancelled = true;
+      }
+      return !cancelled;
+    }
 
-    For more information, see: <http://www.hexblog.com/?p=749>.
-    """
-    if modulename in sys.modules.keys():
-        reload(sys.modules[modulename])
-    else:
-        import importlib
-        import inspect
-        m = importlib.import_module(modulename, package)
-        frame_obj, filename, line_number, function_name, lines, index = inspect.stack()[1]
-        importer_module = inspect.getmodule(frame_obj)
-        if importer_module is None: # No importer module; called from command line
-            importer_module = sys.modules['__main__']
-        setattr(importer_module, modulename, m)
-        sys.modules[modulename] = m
+    qmutex_lock(lock);
+    queue = jobs;
+    qhead = 0;
+    qmutex_unlock(lock);
+    for ( size_t i = 0; i < jobs.size(); ++i )
+      qsem_post(has_job);
 
-# -----------------------------------------------------------------------
+    size_t ndone = 0;
+    while ( ndone < jobs.size() )
+    {
+      if ( qsem_wait(job_done, 100) )
+        ++ndone;
+      if ( !cancelled && (progress != NULL ? !progress(ndone, jobs.size(), ud) : wasBreak()) )
+        cancelled = true;
+    }
+    queue.clear();
+    return !cancelled;
+  }
+};
 
-# Seek constants
-SEEK_SET = 0 # from the file start
-SEEK_CUR = 1 # from the current position
+// NULL if it could not be started
+static worker_pool_t *worker_pool = NULL;
+
+//------------------------------------------------------------------------
+bool pywraps_workers_init()
+{
+  if ( worker_pool != NULL )
+    return true;
+  worker_pool = new worker_pool_t();
+  if ( !worker_pool->start() )
+  {
+    delete worker_pool;
+    worker_pool = NULL;
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------
+void pywraps_workers_term()
+{
+  if ( worker_pool == NULL )
+    return;
+  worker_pool->stop();
+  delete worker_pool;
+  worker_pool = NULL;
+}
+
+//------------------------------------------------------------------------
+// Runs the jobs on the pool, or on the calling thread if there is no pool.
+// Must be called from the main thread, without the GIL.
+static bool run_worker_jobs(const worker_jobs_t &jobs)
+{
+  static worker_pool_t inline_pool;
+  return (worker_pool != NULL ? worker_pool : &inline_pool)->run(jobs);
+}
+
+
+//------------------------------------------------------------------------
+// Sampling profiler: a thread periodically takes the GIL and records the
+// Python stack of the main thread. If, right before, the main thread was
+// not holding the GIL, it was inside a native call that released it (IDA
+// kernel calls, mostly), and the sample is attributed to a "[native]"
+// frame on top of the Python stack.
+// The samples are written in the "collapsed stacks" format used by the
+// flame graph tools: "frame;frame;...;frame count".
+//------------------------------------------------------------------------
+#define PROFILER_NATIVE_FRAME "[native]"
+
+class py_profiler_t
+{
+  typedef std::map<qstring, uint32> stack_counts_t;
+  stack_counts_t counts;
+  PyThreadState *main_tstate;
+  qthread_t thread;
+  qsemaphore_t sem;
+  volatile bool stopping;
+  int interval_ms;
+  uint32 nsamples;
+  uint32 nnative;
+
+  //------------------------------------------------------------------------
+  // Must be called with the GIL
+  void sample(bool in_native)
+  {
+    PyFrameObject *frames[256];
+    int n = 0;
+    for ( PyFrameObject *f = main_tstate->frame; f != NULL && n < int(qnumber(frames)); f = f->f_back )
+      frames[n++] = f;
+    if ( n == 0 )
+      return; // not running Python code
+    qstring key;
+    char buf[MAXSTR];
+    for ( int i = n - 1; i >= 0; --i )
+    {
+      PyCodeObject *co = frames[i]->f_code;
+      const char *file = PyString_Check(co->co_filename) ? PyString_AS_STRING(co->co_filename) : "?";
+      const char *name = PyString_Check(co->co_name) ? PyString_AS_STRING(co->co_name) : "?";
+      qsnprintf(buf, sizeof(buf), "%s (%s:%d)", name, qbasename(file), co->co_firstlineno);
+      if ( !key.empty() )
+        key.append(';');
+      key.append(buf);
+    }
+    if ( in_native )
+    {
+      key.append(";" PROFILER_NATIVE_FRAME);
+      ++nnative;
+    }
+    ++counts[key];
+    ++nsamples;
+  }
+
+  //------------------------------------------------------------------------
+  static int idaapi thread_cb(void *ud)
+  {
+    py_profiler_t *p = (py_profiler_t *)ud;
+    while ( true )
+    {
+      qsem_wait(p->sem, p->interval_ms);
+      if ( p->stopping )
+        break;
+      // Racy read, but it's only a hint: we can't take the GIL to check it
+      bool in_native = _PyThreadState_Current != p->main_tstate;
+      PyGILState_STATE state = PyGILState_Ensure();
+      if ( !p->stopping )
+        p->sample(in_native);
+      PyGILState_Release(state);
+    }
+    return 0;
+  }
+
+public:
+  py_profiler_t()
+    : main_tstate(NULL), thread(NULL), sem(NULL), stopping(false),
+      interval_ms(10), nsamples(0), nnative(0) {}
+
+  bool running() const { return thread != NULL; }
+
+  //------------------------------------------------------------------------
+  // Must be called from the main thread, with the GIL
+  bool start(int _interval_ms)
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    if ( running() )
+      return false;
+    counts.clear();
+    nsamples = nnative = 0;
+    interval_ms = qmax(_interval_ms, 1);
+    main_tstate = PyThreadState_Get();
+    stopping = false;
+    sem = qsem_create(NULL, 0);
+    if ( sem == NULL )
+      return false;
+    thread = qthread_create(thread_cb, this);
+    if ( thread == NULL )
+    {
+      qsem_free(sem);
+      sem = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  //------------------------------------------------------------------------
+  // Must be called with the GIL
+  bool stop()
+  {
+    PYW_GIL_CHECK_LOCKED_SCOPE();
+    if ( !running() )
+      return false;
+    stopping = true;
+    qsem_post(sem);
+    // The sampler may be waiting for the GIL
+    Py_BEGIN_ALLOW_THREADS;
+    qthread_join(thread);
+    Py_END_ALLOW_THREADS;
+    qthread_free(thread);
+    thread = NULL;
+    qsem_free(sem);
+    sem = NULL;
+    msg("IDAPython: profiler: %u samples, %u%% in native calls\n",
+        nsamples, nsamples == 0 ? 0 : uint32(uint64(nnative) * 100 / nsamples));
+    return true;
+  }
+
+  //------------------------------------------------------------------------
+  void get_collapsed(qstring *out) const
+  {
+    out->qclear();
+    char buf[32];
+    for ( stack_counts_t::const_iterator p = counts.begin(); p != counts.end(); ++p )
+    {
+      qsnprintf(buf, sizeof(buf), " %u\n", p->second);
+      out->append(p->first);
+      out->append(buf);
+    }
+  }
+
+  //------------------------------------------------------------------------
+  bool save_collapsed(const char *path) const
+  {
+    FILE *fp = qfopen(path, "w");
+    if ( fp == NULL )
+      return false;
+    qstring out;
+    get_collapsed(&out);
+    bool ok = qfwrite(fp, out.c_str(), out.length()) == ssize_t(out.length());
+    qfclose(fp);
+    return ok;
+  }
+};
+
+static py_profiler_t py_profiler;
+
+//------------------------------------------------------------------------
+bool pywraps_profiler_start(int interval_ms)
+{
+  return py_profiler.start(interval_ms);
+}
+
+//------------------------------------------------------------------------
+// Stops the profiler and writes the collapsed stacks to 'path'
+bool pywraps_profiler_stop(const char *path)
+{
+  if ( !py_profiler.stop() )
+    return false;
+  if ( path == NULL || path[0] == '\0' )
+    return true;
+  if ( !py_profiler.save_collapsed(path) )
+  {
+    msg("IDAPython: profiler: could not write \"%s\"\n", path);
+    return false;
+  }
+  msg("IDAPython: profiler: stacks written to \"%s\"\n", path);
+  return true;
+}
+
+
+//------------------------------------------------------------------------
+// Latency statistics of the calls from the kernel into Python hooks.
+// They are collected per (hook class, event, Python class), and only
+// when enabled: a disabled hook_timer_t costs a single test.
+//------------------------------------------------------------------------
+#define HOOK_STATS_NBUCKETS 24 // bucket 0: < 1us; bucket i: [2^(i-1), 2^i) us; the last one is open
+
+struct hook_stat_key_t
+{
+  const char *hook;     // C++ dispatcher class ("IDB_Hooks", ...)
+  const char *event;    // event name, or NULL if 'code' is used
+  int code;             // event code
+  qstring pyclass;      // Python class of the hook object
+
+  bool operator<(const hook_stat_key_t &r) const
+  {
+    int c = strcmp(hook, r.hook);
+    if ( c != 0 )
+      return c < 0;
+    c = strcmp(event != NULL ? event : "", r.event != NULL ? r.event : "");
+    if ( c != 0 )
+      return c < 0;
+    if ( code != r.code )
+      return code < r.code;
+    return pyclass < r.pyclass;
+  }
+};
+
+struct hook_stat_t
+{
+  uint64 count;
+  uint64 total_ns;
+  uint64 max_ns;
+  uint64 buckets[HOOK_STATS_NBUCKETS];
+  hook_stat_t() { memset(this, 0, sizeof(*this)); }
+};
+
+typedef std::map<hook_stat_key_t, hook_stat_t> hook_stats_t;
+static hook_stats_t hook_stats;
+static bool hook_stats_enabled = false;
+
+//------------------------------------------------------------------------
+// Must be called with the GIL (which also protects 'hook_stats')
+static void record_hook_stat(
+        const char *hook,
+        const char *event,
+        int code,
+        PyTypeObject *pytype,
+        uint64 ns)
+{
+  hook_stat_key_t key;
+  key.hook = hook;
+  key.event = event;
+  key.code = event != NULL ? 0 : code;
+  key.pyclass = pytype != NULL ? pytype->tp_name : "?";
+  hook_stat_t &st = hook_stats[key];
+  ++st.count;
+  st.total_ns += ns;
+  if ( ns > st.max_ns )
+    st.max_ns = ns;
+  int b = 0;
+  for ( uint64 us = ns / 1000; us != 0 && b < HOOK_STATS_NBUCKETS - 1; us >>= 1 )
+    ++b;
+  ++st.buckets[b];
+}
+
+//------------------------------------------------------------------------
+// Python object of a hook: either the object itself, or the Python side
+// of a SWIG director
+static PyObject *hook_stats_self(PyObject *self)
+{
+  return self;
+}
+
+template <class T>
+static PyObject *hook_stats_self(T *proxy)
+{
+  return get_director_self(proxy);
+}
+
+//------------------------------------------------------------------------
+// Times the call into Python for the duration of its scope.
+// Must be declared after PYW_GIL_GET, so that it records with the GIL.
+class hook_timer_t
+{
+  const char *hook;
+  const char *event;
+  int code;
+  PyTypeObject *pytype;
+  uint64 t0;
+
+  void init(PyObject *self)
+  {
+    // Keep the type alive: the object may be gone by the end of the scope
+    // (e.g., a chooser deleted in its OnClose)
+    if ( self != NULL )
+    {
+      pytype = Py_TYPE(self);
+      Py_INCREF(pytype);
+    }
+    t0 = get_nsec_stamp();
+  }
+
+public:
+  template <class T>
+  hook_timer_t(const char *_hook, int _code, T *obj)
+    : hook(_hook), event(NULL), code(_code), pytype(NULL), t0(0)
+  {
+    if ( hook_stats_enabled )
+      init(hook_stats_self(obj));
+  }
+
+  template <class T>
+  hook_timer_t(const char *_hook, const char *_event, T *obj)
+    : hook(_hook), event(_event), code(0), pytype(NULL), t0(0)
+  {
+    if ( hook_stats_enabled )
+      init(hook_stats_self(obj));
+  }
+
+  ~hook_timer_t()
+  {
+    if ( t0 == 0 )
+      return;
+    record_hook_stat(hook, event, code, pytype, get_nsec_stamp() - t0);
+    Py_XDECREF(pytype);
+  }
+};
+
+
+//------------------------------------------------------------------------
+// LRU cache of the code objects compiled from the expressions and
+// statements that IDA passes to Python (extlang calcexpr/run_statements,
+// the CLI): breakpoint conditions, for example, are evaluated over and
+// over again.
+// The cache is bounded both in entries and in source text bytes, and it
+// is protected by the GIL.
+//------------------------------------------------------------------------
+#define CODE_CACHE_MAX_ENTRIES 256
+#define CODE_CACHE_MAX_BYTES   (1024 * 1024)
+
+struct code_cache_key_t
+{
+  int mode;       // Py_eval_input, Py_file_input, ...
+  qstring text;
+
+  bool operator<(const code_cache_key_t &r) const
+  {
+    if ( mode != r.mode )
+      return mode < r.mode;
+    return text < r.text;
+  }
+};
+
+struct code_cache_entry_t
+{
+  PyObject *code;
+  uint64 stamp;   // last use, the key of the entry in 'lru'
+};
+
+typedef std::map<code_cache_key_t, code_cache_entry_t> code_cache_map_t;
+typedef std::map<uint64, code_cache_map_t::iterator> code_cache_lru_t;
+
+struct code_cache_t
+{
+  code_cache_map_t entries;
+  code_cache_lru_t lru;       // least recently used first
+  uint64 stamp;
+  size_t bytes;               // source text in the cache
+  size_t max_entries;
+  size_t max_bytes;
+  uint64 hits;
+  uint64 misses;
+
+  code_cache_t()
+    : stamp(0), bytes(0),
+      max_entries(CODE_CACHE_MAX_ENTRIES), max_bytes(CODE_CACHE_MAX_BYTES),
+      hits(0), misses(0) {}
+
+  void erase(code_cache_map_t::iterator p)
+  {
+    PyObject *code = p->second.code;
+    bytes -= p->first.text.length();
+    lru.erase(p->second.stamp);
+    entries.erase(p);
+    Py_DECREF(code);
+  }
+
+  // Evicts the least recently used entries until 'n' more bytes fit
+  void shrink(size_t n)
+  {
+    while ( !lru.empty() && (entries.size() >= max_entries || bytes + n > max_bytes) )
+      erase(lru.begin()->second);
+  }
+
+  void flush()
+  {
+    while ( !lru.empty() )
+      erase(lru.begin()->second);
+  }
+
+  PyObject *compile(const char *str, int mode);
+};
+static code_cache_t code_cache;
+
+//------------------------------------------------------------------------
+// Returns a new reference to the code object of 'str', compiled in 'mode'.
+// On error, returns NULL with the Python exception set.
+PyObject *code_cache_t::compile(const char *str, int mode)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache_key_t key;
+  key.mode = mode;
+  key.text = str;
+  code_cache_map_t::iterator p = entries.find(key);
+  if ( p != entries.end() )
+  {
+    ++hits;
+    lru.erase(p->second.stamp);
+    p->second.stamp = ++stamp;
+    lru[stamp] = p;
+    Py_INCREF(p->second.code);
+    return p->second.code;
+  }
+
+  ++misses;
+  PyCompilerFlags cf = {0};
+  PyObject *code = Py_CompileStringFlags(str, "<string>", mode, &cf);
+  if ( code == NULL )
+    return NULL;
+
+  // Too large to be cached?
+  size_t len = key.text.length();
+  if ( len > max_bytes || max_entries == 0 )
+    return code;
+
+  shrink(len);
+  code_cache_entry_t &e = entries[key];
+  e.code = code;
+  e.stamp = ++stamp;
+  lru[stamp] = entries.find(key);
+  bytes += len;
+  Py_INCREF(code);
+  return code;
+}
+
+//------------------------------------------------------------------------
+PyObject *pywraps_compile_cached(const char *str, int mode)
+{
+  return code_cache.compile(str, mode);
+}
+
+//------------------------------------------------------------------------
+// Must be called with the GIL, before Py_Finalize()
+void pywraps_code_cache_flush()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache.flush();
+}
+//</code(py_idaapi)>
+%}
+
+// Do not create separate wrappers for default arguments
+%feature("compactdefaultargs");
+
+%constant ea_t BADADDR = ea_t(-1);
+%constant sel_t BADSEL = sel_t(-1);
+%constant nodeidx_t BADNODE = nodeidx_t(-1);
+
+// Help SWIG to figure out the ulonglong type
+#ifdef SWIGWIN
+typedef unsigned __int64 ulonglong;
+typedef          __int64 longlong;
+#else
+typedef unsigned long long ulonglong;
+typedef          long long longlong;
+#endif
+
+typedef int error_t;
+
+%include "typemaps.i"
+
+%include "cstring.i"
+%include "carrays.i"
+%include "cpointer.i"
+
+%include "typeconv.i"
+
+%pythoncode %{
+#<pycode(py_idaapi)>
+
+import struct
+import traceback
+import os
+import sys
+import bisect
+import __builtin__
+import imp
+import marshal
+import hashlib
+
+def require(modulename, package=None):
+    """
+    Load, or reload a module.
+
+    When under heavy development, a user's tool might consist of multiple
+    modules. If those are imported using the standard 'import' mechanism,
+    there is no guarantee that the Python implementation will re-read
+    and re-evaluate the module's Python code. In fact, it usually doesn't.
+    What should be done instead is 'reload()'-ing that module.
+
+    This is a simple helper function that will do just that: In case the
+    module doesn't exist, it 'import's it, and if it does exist,
+    'reload()'s it.
+
+    For more information, see: <http://www.hexblog.com/?p=749>.
+    """
+    if modulename in sys.modules.keys():
+        reload(sys.modules[modulename])
+    else:
+        import importlib
+        import inspect
+        m = importlib.import_module(modulename, package)
+        frame_obj, filename, line_number, function_name, lines, index = inspect.stack()[1]
+        importer_module = inspect.getmodule(frame_obj)
+        if importer_module is None: # No importer module; called from command line
+            importer_module = sys.modules['__main__']
+        setattr(importer_module, modulename, m)
+        sys.modules[modulename] = m
+
+# -----------------------------------------------------------------------
+
+# Seek constants
+SEEK_SET = 0 # from the file start
+SEEK_CUR = 1 # from the current position
 SEEK_END = 2 # from the file end
 
+# Script break modes (see set_script_break_mode())
+SCRIPT_BREAK_TRACE    = 0 # a trace function, called on every interpreter event
+SCRIPT_BREAK_WATCHDOG = 1 # a watchdog thread, that schedules pending calls
+
 # Plugin constants
 PLUGIN_MOD  = 0x0001
 PLUGIN_DRAW = 0x0002
@@ -2275,6 +3296,124 @@ def IDAPython_FormatExc(etype, value, tb, limit=None):
         return str(value)
 
 
+# ------------------------------------------------------------
+# Compiled scripts cache.
+# The code objects of the scripts run by IDAPython_ExecScript() are kept
+# in 'pycache' under the user IDA directory, one file per script path.
+# A cache file starts with the interpreter magic, followed by the marshaled
+# tuple (path, mtime, size, code): it is used only if the script did not
+# change since it was compiled.
+__script_cache_stats = { "hits": 0, "misses": 0, "errors": 0 }
+__script_cache_enabled = True
+
+def __script_cache_file(path):
+    cachedir = os.path.join(get_user_idadir(), "pycache")
+    name = os.path.splitext(os.path.basename(path))[0]
+    if isinstance(path, unicode):
+        path = path.encode("utf-8")
+    return cachedir, os.path.join(
+        cachedir,
+        "%s.%s.pyc" % (name, hashlib.sha1(path).hexdigest()[:16]))
+
+
+def __script_cache_load(cachefile, key):
+    try:
+        with open(cachefile, "rb") as f:
+            if f.read(4) != imp.get_magic():
+                return None
+            data = marshal.load(f)
+    except IOError:
+        return None
+    except (EOFError, ValueError, TypeError):
+        __script_cache_stats["errors"] += 1
+        return None
+    if type(data) is not tuple or len(data) != 4 or data[:3] != key:
+        return None
+    return data[3]
+
+
+def __script_cache_store(cachedir, cachefile, key, code):
+    tmpfile = "%s.%d.tmp" % (cachefile, os.getpid())
+    try:
+        if not os.path.isdir(cachedir):
+            os.makedirs(cachedir)
+        with open(tmpfile, "wb") as f:
+            f.write(imp.get_magic())
+            marshal.dump(key + (code,), f)
+        try:
+            os.rename(tmpfile, cachefile)
+        except OSError:
+            # os.rename() does not replace an existing file on Windows
+            try:
+                os.remove(cachefile)
+                os.rename(tmpfile, cachefile)
+            except OSError:
+                # Another IDA instance wrote the same cache file in the
+                # meantime: keep its copy
+                if not os.path.exists(cachefile):
+                    raise
+                os.remove(tmpfile)
+    except (IOError, OSError, ValueError):
+        __script_cache_stats["errors"] += 1
+        try:
+            os.remove(tmpfile)
+        except OSError:
+            pass
+
+
+def IDAPython_CompileScript(script):
+    """
+    Returns the code object of a script, from the compiled scripts cache
+    if the script did not change since it was last compiled.
+    Raises the compilation errors, as execfile() would.
+    """
+    path = os.path.abspath(script)
+    with open(path, "rU") as f:
+        st = os.fstat(f.fileno())
+        if not __script_cache_enabled:
+            return compile(f.read(), script, "exec", 0, True)
+
+        key = (path, st.st_mtime, st.st_size)
+        cachedir, cachefile = __script_cache_file(path)
+        code = __script_cache_load(cachefile, key)
+        if code is not None and code.co_filename == script:
+            __script_cache_stats["hits"] += 1
+            return code
+
+        __script_cache_stats["misses"] += 1
+        code = compile(f.read(), script, "exec", 0, True)
+    __script_cache_store(cachedir, cachefile, key, code)
+    return code
+
+
+def enable_script_cache(enable):
+    """
+    Enables or disables the compiled scripts cache used by
+    IDAPython_ExecScript() (and thus by File/Script file, idapythonrc.py, ...)
+
+    @return: Boolean, the previous state
+    """
+    global __script_cache_enabled
+    old = __script_cache_enabled
+    __script_cache_enabled = bool(enable)
+    return old
+
+
+def get_script_cache_stats():
+    """
+    Returns the statistics of the compiled scripts cache, as a dictionary:
+      - hits: scripts loaded from the cache
+      - misses: scripts compiled from source
+      - errors: unreadable or unwritable cache files
+    """
+    return dict(__script_cache_stats)
+
+
+def reset_script_cache_stats():
+    """Resets the statistics of the compiled scripts cache"""
+    for k in __script_cache_stats:
+        __script_cache_stats[k] = 0
+
 # ------------------------------------------------------------
 def IDAPython_ExecScript(script, g):
     """
@@ -2295,7 +3434,7 @@ def IDAPython_ExecScript(script, g):
     g['__file__'] = script
 
     try:
-        execfile(script, g)
+        exec IDAPython_CompileScript(script) in g
         PY_COMPILE_ERR = None
     except Exception as e:
         PY_COMPILE_ERR = "%s\n%s" % (str(e), traceback.format_exc())
@@ -2599,6 +3738,29 @@ def disable_script_timeout():
 */
 void disable_script_timeout();
 
+/*
+#<pydoc>
+def set_script_break_mode(mode):
+    """
+    Changes how the running scripts check for the script timeout and for
+    the wait box Cancel button. The new mode is used from the next script
+    execution on.
+
+    @param mode: SCRIPT_BREAK_TRACE (the default): a trace function is
+                 called on every interpreter event.
+                 SCRIPT_BREAK_WATCHDOG: a watchdog thread periodically
+                 schedules the check (see Py_AddPendingCall), which costs
+                 nothing to the script in between. The checks only start
+                 once the script timeout has elapsed: until then, the
+                 Cancel button of a wait box shown by the script itself
+                 does not interrupt it.
+    @return: Returns the old mode, or -1 if 'mode' is invalid
+    """
+    pass
+#</pydoc>
+*/
+int set_script_break_mode(int mode);
+
 /*
 #<pydoc>
 def enable_extlang_python(enable):
@@ -2734,6 +3896,41 @@ static bool qstrvec_t_remove(PyObject *self, size_t idx)
 //---------------------------------------------------------------------------
 
 
+/*
+#<pydoc>
+def get_startup_profile():
+    """
+    Returns the time taken by the IDAPython startup phases, and by the
+    NW_INITIDA and NW_OPENIDB notify_when() callbacks (for the last
+    database opened).
+    Setting the IDAPYTHON_STARTUP_PROFILE environment variable to 1 prints
+    the profile in the output window at startup and after each NW_OPENIDB.
+    Setting it to a path writes it to that file instead, one phase per line.
+    @return: a list of (phase, duration in ns) tuples, in the order
+             the phases ran
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *get_startup_profile()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  newref_t py_list(PyList_New(startup_phases.size()));
+  if ( py_list == NULL )
+    return NULL;
+  for ( size_t i = 0; i < startup_phases.size(); ++i )
+  {
+    const startup_phase_t &ph = startup_phases[i];
+    PyObject *py_ph = Py_BuildValue("(sK)", ph.name.c_str(), (unsigned PY_LONG_LONG)ph.ns);
+    if ( py_ph == NULL )
+      return NULL;
+    PyList_SET_ITEM(py_list.o, i, py_ph);
+  }
+  py_list.incref();
+  return py_list.o;
+}
+
+
 
 //------------------------------------------------------------------------
 /*
@@ -2760,6 +3957,225 @@ static bool notify_when(int when, PyObject *py_callable)
   return g_nw->notify_when(when, py_callable);
 }
 
+
+
+/*
+#<pydoc>
+def get_worker_count():
+    """
+    Returns the number of native worker threads used by the scanning
+    functions (find_patterns(), get_block_entropy(), ...).
+    0 means that they run on the main thread.
+    """
+    pass
+#</pydoc>
+*/
+static size_t get_worker_count()
+{
+  return worker_pool == NULL ? 0 : worker_pool->size();
+}
+
+
+/*
+#<pydoc>
+def profiler_start(interval_ms = 10):
+    """
+    Starts the sampling profiler. Every 'interval_ms' milliseconds, the
+    Python stack of the main thread is recorded. The time spent in native
+    calls that release the GIL (IDA kernel calls, mostly) is attributed to
+    a "[native]" frame.
+    The profiler can also be started from the command line:
+      -OIDAPython:profile=<outfile>[,<interval_ms>];[<when>;]<script>
+    @param interval_ms: sampling interval
+    @return: False if the profiler is already running
+    """
+    pass
+#</pydoc>
+*/
+static bool profiler_start(int interval_ms = 10)
+{
+  return pywraps_profiler_start(interval_ms);
+}
+
+/*
+#<pydoc>
+def profiler_stop(outfile = None):
+    """
+    Stops the sampling profiler.
+    @param outfile: file where to write the collapsed stacks (as read by
+                    flamegraph.pl), or None
+    @return: if 'outfile' is None, the collapsed stacks as a string,
+             or None if the profiler was not running.
+             Otherwise, whether the file was written.
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *profiler_stop(const char *outfile = NULL)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( outfile != NULL )
+    return PyBool_FromLong(pywraps_profiler_stop(outfile));
+  if ( !pywraps_profiler_stop(NULL) )
+    Py_RETURN_NONE;
+  qstring out;
+  py_profiler.get_collapsed(&out);
+  return PyString_FromStringAndSize(out.c_str(), out.length());
+}
+
+
+/*
+#<pydoc>
+def enable_hook_stats(enable):
+    """
+    Enables or disables the collection of latency statistics for the calls
+    from IDA into Python hooks (IDB_Hooks, IDP_Hooks, DBG_Hooks, UI_Hooks,
+    Choose2 and GraphViewer callbacks).
+    @param enable: True to collect the statistics
+    @return: the previous state
+    """
+    pass
+#</pydoc>
+*/
+static bool enable_hook_stats(bool enable)
+{
+  bool old = hook_stats_enabled;
+  hook_stats_enabled = enable;
+  return old;
+}
+
+/*
+#<pydoc>
+def reset_hook_stats():
+    """
+    Forgets the statistics collected so far.
+    """
+    pass
+#</pydoc>
+*/
+static void reset_hook_stats()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  hook_stats.clear();
+}
+
+/*
+#<pydoc>
+def get_hook_stats():
+    """
+    Returns the statistics collected since the last reset_hook_stats().
+    @return: a dictionary {(hook, event, pyclass): stats}, where:
+             - hook is the name of the hook class ("IDB_Hooks", ...)
+             - event is the notification code, or the method name for
+               the callbacks that have no code (Choose2)
+             - pyclass is the name of the Python class of the hook object
+             - stats is a dictionary with the 'count', 'total_ns' and
+               'max_ns' keys, and 'buckets': a list of counts, where
+               buckets[0] counts the calls faster than 1us and buckets[i]
+               the calls in [2**(i-1), 2**i) us (the last one is open).
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *get_hook_stats()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  newref_t py_dict(PyDict_New());
+  if ( py_dict == NULL )
+    return NULL;
+  for ( hook_stats_t::const_iterator p = hook_stats.begin(); p != hook_stats.end(); ++p )
+  {
+    const hook_stat_key_t &k = p->first;
+    const hook_stat_t &st = p->second;
+    newref_t py_buckets(PyList_New(HOOK_STATS_NBUCKETS));
+    if ( py_buckets == NULL )
+      return NULL;
+    for ( int i = 0; i < HOOK_STATS_NBUCKETS; ++i )
+      PyList_SET_ITEM(py_buckets.o, i, PyLong_FromUnsignedLongLong(st.buckets[i]));
+    newref_t py_key(k.event != NULL
+                  ? Py_BuildValue("(sss)", k.hook, k.event, k.pyclass.c_str())
+                  : Py_BuildValue("(sis)", k.hook, k.code, k.pyclass.c_str()));
+    newref_t py_st(Py_BuildValue("{s:K,s:K,s:K,s:O}",
+                                 "count", (unsigned PY_LONG_LONG)st.count,
+                                 "total_ns", (unsigned PY_LONG_LONG)st.total_ns,
+                                 "max_ns", (unsigned PY_LONG_LONG)st.max_ns,
+                                 "buckets", py_buckets.o));
+    if ( py_key == NULL || py_st == NULL || PyDict_SetItem(py_dict.o, py_key.o, py_st.o) != 0 )
+      return NULL;
+  }
+  py_dict.incref();
+  return py_dict.o;
+}
+
+
+/*
+#<pydoc>
+def get_code_cache_stats():
+    """
+    Returns the statistics of the cache of the compiled expressions and
+    statements (extlang calcexpr and run_statements, command line), as a
+    dictionary with the following keys:
+      - hits, misses: lookups since the last flush_code_cache()
+      - entries, bytes: number of code objects in the cache, and length
+                        of their source text
+      - max_entries, max_bytes: limits of the cache
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *get_code_cache_stats()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  return Py_BuildValue("{s:K,s:K,s:n,s:n,s:n,s:n}",
+                       "hits", (unsigned PY_LONG_LONG)code_cache.hits,
+                       "misses", (unsigned PY_LONG_LONG)code_cache.misses,
+                       "entries", (Py_ssize_t)code_cache.entries.size(),
+                       "bytes", (Py_ssize_t)code_cache.bytes,
+                       "max_entries", (Py_ssize_t)code_cache.max_entries,
+                       "max_bytes", (Py_ssize_t)code_cache.max_bytes);
+}
+
+/*
+#<pydoc>
+def flush_code_cache():
+    """
+    Empties the cache of the compiled expressions and statements, and
+    resets its statistics.
+    """
+    pass
+#</pydoc>
+*/
+static void flush_code_cache()
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache.flush();
+  code_cache.hits = 0;
+  code_cache.misses = 0;
+}
+
+/*
+#<pydoc>
+def set_code_cache_limits(max_entries, max_bytes):
+    """
+    Sets the limits of the cache of the compiled expressions and
+    statements. The least recently used code objects are evicted first.
+    @param max_entries: maximal number of code objects (0 disables the cache)
+    @param max_bytes: maximal total length of their source text
+    """
+    pass
+#</pydoc>
+*/
+static void set_code_cache_limits(size_t max_entries, size_t max_bytes)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  code_cache.max_entries = max_entries;
+  code_cache.max_bytes = max_bytes;
+  while ( !code_cache.lru.empty()
+       && (code_cache.entries.size() > max_entries || code_cache.bytes > max_bytes) )
+  {
+    code_cache.erase(code_cache.lru.begin()->second);
+  }
+}
 //</inline(py_idaapi)>
 %}
 
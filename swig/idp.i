@@ -32,6 +32,16 @@
 %ignore ph;
 %ignore IDB_Callback;
 %ignore IDP_Callback;
+%ignore get_idb_hooks_overridden;
+%ignore get_idp_hooks_overridden;
+%ignore idb_batch_t;
+%ignore idb_batch_create;
+%ignore idb_batch_flush;
+%ignore idb_batch_free;
+%ignore idb_async_t;
+%ignore idb_async_create;
+%ignore idb_async_free;
+%ignore idb_async_get_stats;
 %ignore _py_getreg;
 %ignore free_processor_module;
 %ignore read_config_file;
@@ -488,6 +498,9 @@ class IDP_Hooks(object):
     def hook(self):
         """
         Creates an IDP hook
+        Only the events whose method is overridden at the time of the call
+        are dispatched to Python: call unhook() and hook() after adding
+        methods to the object or its class.
 
         @return: Boolean true on success
         """
@@ -743,9 +756,17 @@ class IDP_Hooks(object):
 // IDP hooks
 //---------------------------------------------------------------------------
 int idaapi IDP_Callback(void *ud, int notification_code, va_list va);
+uint64 get_idp_hooks_overridden(PyObject *self);
 class IDP_Hooks
 {
+  friend int idaapi IDP_Callback(void *ud, int notification_code, va_list va);
+
+  // Events handled in Python (bitmask of idp_hook_events[] indexes)
+  uint64 overridden;
+
 public:
+  IDP_Hooks() : overridden(0) {}
+
   virtual ~IDP_Hooks()
   {
     unhook();
@@ -753,6 +774,7 @@ public:
 
   bool hook()
   {
+    overridden = get_idp_hooks_overridden(get_director_self(this));
     return hook_to_notification_point(HT_IDP, IDP_Callback, this);
   }
 
@@ -886,23 +908,189 @@ enum areacb_type_t
   AREACB_TYPE_SRAREA,
 };
 
+//---------------------------------------------------------------------------
+/*
+#<pydoc>
+class IDB_Hooks(object):
+    def set_batch_mode(self, max_events, flush_ms = 500):
+        """
+        Enables or disables the batch mode.
+        In batch mode, the events are not dispatched to their methods:
+        they are queued, and delivered together to on_batch(). The queue
+        is delivered when it holds 'max_events' events, when the
+        auto-analysis queue becomes empty, every 'flush_ms' milliseconds
+        while the auto-analysis is idle, on flush_batch() and on unhook().
+        The events still queued when the hook object is destroyed are
+        dropped: call unhook() or set_batch_mode(0) before, to get the
+        last batch.
+
+        @param max_events: size of the queue. 0 disables the batch mode
+                           (after delivering the queued events).
+        @param flush_ms: period of the idle check, or 0 for none
+        @return: Boolean
+        """
+        pass
+
+    def flush_batch(self):
+        """
+        Delivers the queued events to on_batch() now.
+        """
+        pass
+
+    def on_batch(self, events):
+        """
+        Called with the queued events, in batch mode.
+
+        @param events: a list of (name, ea1, ea2, n) tuples:
+                       - name is the name of the event method ('byte_patched', ...)
+                       - ea1 and ea2 are the addresses or ids passed to that
+                         method, in order (ea2 is BADADDR if there is no
+                         second one). For structure events, they are the
+                         structure and member ids.
+                       - n is the operand number, or the repeatable flag,
+                         or 0
+                       Repeated events are coalesced: for byte_patched,
+                       [ea1, ea2) is a range of patched bytes.
+                       In asynchronous mode, the tuples have a fifth item:
+                       the text that goes with the event (comment, name of
+                       the structure, member or enum), or None. For
+                       ti_changed and op_ti_changed, it is a (type, fnames)
+                       tuple of serialized type strings, as returned by
+                       GetTinfo() (fnames is None if the type has no field
+                       names), or None.
+        """
+        pass
+
+    def set_async_mode(self, capacity, policy = IDBA_DROP_NEW, max_batch = 256):
+        """
+        Enables or disables the asynchronous mode.
+        In asynchronous mode, the events are copied (with their text) to a
+        bounded queue, and a worker thread delivers them to on_batch() by
+        batches of at most 'max_batch' events. IDA does not wait for
+        on_batch(), which runs on the worker thread: it must not call the
+        IDA API (except through execute_sync()).
+        The hook object is kept alive until the asynchronous mode is
+        disabled, or until unhook(). Both wait for the queued events to be
+        delivered.
+
+        @param capacity: size of the queue. 0 disables the asynchronous mode.
+        @param policy: what to do when the queue is full:
+                       - IDBA_DROP_NEW: drop the new event
+                       - IDBA_DROP_OLD: drop the oldest queued event
+                       - IDBA_BLOCK: wait for the worker thread (and drop
+                         the new event if it does not make room within
+                         a second)
+        @param max_batch: maximum number of events per on_batch() call
+        @return: Boolean
+        """
+        pass
+
+    def get_async_stats(self):
+        """
+        Returns the counters of the asynchronous mode, as a dictionary with
+        the following keys: 'queued', 'delivered', 'dropped', 'blocked'
+        (number of events that had to wait for room), 'max_depth' (highest
+        number of queued events) and 'depth' (current number).
+        None if the asynchronous mode is disabled.
+        """
+        pass
+#</pydoc>
+*/
+// What IDB_Hooks does with an event when the queue of its asynchronous
+// mode is full
+enum idb_async_policy_t
+{
+  IDBA_DROP_NEW,        // drop the event
+  IDBA_DROP_OLD,        // drop the oldest queued event
+  IDBA_BLOCK,           // wait for the worker thread to make room
+};
 //---------------------------------------------------------------------------
 // IDB hooks
 //---------------------------------------------------------------------------
 int idaapi IDB_Callback(void *ud, int notification_code, va_list va);
+uint64 get_idb_hooks_overridden(PyObject *self);
+class IDB_Hooks;
+struct idb_batch_t;
+idb_batch_t *idb_batch_create(IDB_Hooks *hooks, size_t max_events, int flush_ms);
+void idb_batch_flush(idb_batch_t *batch);
+void idb_batch_free(idb_batch_t *batch);
+struct idb_async_t;
+idb_async_t *idb_async_create(IDB_Hooks *hooks, size_t capacity, int policy, size_t max_batch);
+bool idb_async_free(idb_async_t *async);
+PyObject *idb_async_get_stats(const idb_async_t *async);
 class IDB_Hooks
 {
+  friend int idaapi IDB_Callback(void *ud, int notification_code, va_list va);
+
+  // Events handled in Python (bitmask of idb_hook_events[] indexes)
+  uint64 overridden;
+
+  // Queued events, in batch mode
+  idb_batch_t *batch;
+
+  // Event queue and worker thread, in asynchronous mode
+  idb_async_t *async;
+
 public:
-  virtual ~IDB_Hooks() { unhook(); };
+  IDB_Hooks() : overridden(0), batch(NULL), async(NULL) {}
+  virtual ~IDB_Hooks()
+  {
+    // Don't flush the queued events: the Python part of the object is
+    // already gone, and on_batch() would no longer reach it
+    unhook_from_notification_point(HT_IDB, IDB_Callback, this);
+    set_async_mode(0);
+    idb_batch_free(batch);
+  }
 
   bool hook()
   {
+    overridden = get_idb_hooks_overridden(get_director_self(this));
     return hook_to_notification_point(HT_IDB, IDB_Callback, this);
   }
   bool unhook()
   {
+    flush_batch();
+    set_async_mode(0);
     return unhook_from_notification_point(HT_IDB, IDB_Callback, this);
   }
+
+  bool set_batch_mode(size_t max_events, int flush_ms = 500)
+  {
+    flush_batch();
+    idb_batch_free(batch);
+    batch = NULL;
+    if ( max_events == 0 )
+      return true;
+    if ( !set_async_mode(0) )
+      return false;
+    batch = idb_batch_create(this, max_events, flush_ms);
+    return batch != NULL;
+  }
+  bool set_async_mode(size_t capacity, int policy = IDBA_DROP_NEW, size_t max_batch = 256)
+  {
+    if ( async != NULL )
+    {
+      if ( !idb_async_free(async) )
+        return false; // called from on_batch()
+      async = NULL;
+    }
+    if ( capacity == 0 )
+      return true;
+    set_batch_mode(0);
+    async = idb_async_create(this, capacity, policy, max_batch);
+    return async != NULL;
+  }
+  PyObject *get_async_stats()
+  {
+    return idb_async_get_stats(async);
+  }
+  void flush_batch()
+  {
+    if ( batch != NULL )
+      idb_batch_flush(batch);
+  }
+  virtual void on_batch(PyObject * /*events*/) {}
+
   // Hook functions to override in Python
   virtual int byte_patched(ea_t /*ea*/) { return 0; }
   virtual int cmt_changed(ea_t, bool /*repeatable_cmt*/) { return 0; }
@@ -943,12 +1131,56 @@ public:
 
 %{
 //<code(py_idp)>
+//-------------------------------------------------------------------------
+// Events dispatched by IDP_Callback()
+static const hook_event_t idp_hook_events[] =
+{
+  { processor_t::custom_ana,         "custom_ana",         0 },
+  { processor_t::custom_out,         "custom_out",         0 },
+  { processor_t::custom_emu,         "custom_emu",         0 },
+  { processor_t::custom_outop,       "custom_outop",       0 },
+  { processor_t::custom_mnem,        "custom_mnem",        0 },
+  { processor_t::is_sane_insn,       "is_sane_insn",       0 },
+  { processor_t::may_be_func,        "may_be_func",        0 },
+  { processor_t::closebase,          "closebase",          0 },
+  { processor_t::savebase,           "savebase",           0 },
+  { processor_t::auto_empty_finally, "auto_empty_finally", 0 },
+  { processor_t::rename,             "rename",             0 },
+  { processor_t::renamed,            "renamed",            0 },
+  { processor_t::undefine,           "undefine",           0 },
+  { processor_t::make_code,          "make_code",          0 },
+  { processor_t::make_data,          "make_data",          0 },
+  { processor_t::load_idasgn,        "load_idasgn",        0 },
+  { processor_t::auto_empty,         "auto_empty",         0 },
+  { processor_t::auto_queue_empty,   "auto_queue_empty",   1 },
+  { processor_t::add_func,           "add_func",           0 },
+  { processor_t::del_func,           "del_func",           0 },
+  { processor_t::is_call_insn,       "is_call_insn",       0 },
+  { processor_t::is_ret_insn,        "is_ret_insn",        0 },
+  { processor_t::assemble,           "assemble",           0 },
+};
+
+//-------------------------------------------------------------------------
+uint64 get_idp_hooks_overridden(PyObject *self)
+{
+  return get_overridden_events(self, "IDP_Hooks", idp_hook_events, qnumber(idp_hook_events));
+}
+
 //-------------------------------------------------------------------------
 int idaapi IDP_Callback(void *ud, int notification_code, va_list va)
 {
+  IDP_Hooks *proxy = (IDP_Hooks *)ud;
+
+  // Don't take the GIL for the events the Python class doesn't handle
+  int idx = find_hook_event(idp_hook_events, qnumber(idp_hook_events), notification_code);
+  if ( idx < 0 )
+    return 0;
+  if ( (proxy->overridden & (uint64(1) << idx)) == 0 )
+    return idp_hook_events[idx].defret;
+
   // This hook gets called from the kernel. Ensure we hold the GIL.
   PYW_GIL_GET;
-  IDP_Hooks *proxy = (IDP_Hooks *)ud;
+  hook_timer_t timer("IDP_Hooks", notification_code, proxy);
   int ret = 0;
   try
   {
@@ -1457,12 +1689,711 @@ int idaapi IDP_Callback(void *ud, int notification_code, va_list va)
 }
 
 //---------------------------------------------------------------------------
-int idaapi IDB_Callback(void *ud, int notification_code, va_list va)
+// Events dispatched by IDB_Callback()
+static const hook_event_t idb_hook_events[] =
 {
-  // This hook gets called from the kernel. Ensure we hold the GIL.
+  { idb_event::byte_patched,         "byte_patched",         0 },
+  { idb_event::cmt_changed,          "cmt_changed",          0 },
+  { idb_event::area_cmt_changed,     "area_cmt_changed",     0 },
+  { idb_event::ti_changed,           "ti_changed",           0 },
+  { idb_event::op_ti_changed,        "op_ti_changed",        0 },
+  { idb_event::op_type_changed,      "op_type_changed",      0 },
+  { idb_event::enum_created,         "enum_created",         0 },
+  { idb_event::enum_deleted,         "enum_deleted",         0 },
+  { idb_event::enum_bf_changed,      "enum_bf_changed",      0 },
+  { idb_event::enum_cmt_changed,     "enum_cmt_changed",     0 },
+#ifdef NO_OBSOLETE_FUNCS
+  { idb_event::enum_member_created,  "enum_member_created",  0 },
+  { idb_event::enum_member_deleted,  "enum_member_deleted",  0 },
+#else
+  { idb_event::enum_const_created,   "enum_member_created",  0 },
+  { idb_event::enum_const_deleted,   "enum_member_deleted",  0 },
+#endif
+  { idb_event::struc_created,        "struc_created",        0 },
+  { idb_event::struc_deleted,        "struc_deleted",        0 },
+  { idb_event::struc_renamed,        "struc_renamed",        0 },
+  { idb_event::struc_expanded,       "struc_expanded",       0 },
+  { idb_event::struc_cmt_changed,    "struc_cmt_changed",    0 },
+  { idb_event::struc_member_created, "struc_member_created", 0 },
+  { idb_event::struc_member_deleted, "struc_member_deleted", 0 },
+  { idb_event::struc_member_renamed, "struc_member_renamed", 0 },
+  { idb_event::struc_member_changed, "struc_member_changed", 0 },
+  { idb_event::thunk_func_created,   "thunk_func_created",   0 },
+  { idb_event::func_tail_appended,   "func_tail_appended",   0 },
+  { idb_event::func_tail_removed,    "func_tail_removed",    0 },
+  { idb_event::tail_owner_changed,   "tail_owner_changed",   0 },
+  { idb_event::func_noret_changed,   "func_noret_changed",   0 },
+  { idb_event::segm_added,           "segm_added",           0 },
+  { idb_event::segm_deleted,         "segm_deleted",         0 },
+  { idb_event::segm_start_changed,   "segm_start_changed",   0 },
+  { idb_event::segm_end_changed,     "segm_end_changed",     0 },
+  { idb_event::segm_moved,           "segm_moved",           0 },
+};
+
+//---------------------------------------------------------------------------
+uint64 get_idb_hooks_overridden(PyObject *self)
+{
+  return get_overridden_events(self, "IDB_Hooks", idb_hook_events, qnumber(idb_hook_events));
+}
+
+//---------------------------------------------------------------------------
+// Batch mode of IDB_Hooks: the events are queued without taking the GIL,
+// and delivered together to IDB_Hooks.on_batch()
+struct idb_batch_event_t
+{
+  int idx;              // index in idb_hook_events[]
+  int n;                // operand number, repeatable flag, or 0
+  ea_t ea1;             // first address or id
+  ea_t ea2;             // second address or id, or BADADDR
+};
+typedef qvector<idb_batch_event_t> idb_batch_events_t;
+
+struct idb_batch_t
+{
+  IDB_Hooks *hooks;
+  idb_batch_events_t events;
+  size_t max_events;
+  int flush_ms;
+  qtimer_t timer;
+  bool flushing;
+};
+
+//---------------------------------------------------------------------------
+// Extracts the arguments of an IDB event and, if 'text' is not NULL, the
+// text that goes with it (the asynchronous consumers can't query it later).
+// For the type events, 'text' gets the serialized type, and 'fnames' its
+// serialized field names.
+static bool get_idb_batch_event(
+        idb_batch_event_t *ev,
+        int code,
+        va_list va,
+        qstring *text = NULL,
+        qstring *fnames = NULL)
+{
+  ev->idx = find_hook_event(idb_hook_events, qnumber(idb_hook_events), code);
+  if ( ev->idx < 0 )
+    return false;
+  ev->n = 0;
+  ev->ea2 = BADADDR;
+  switch ( code )
+  {
+    case idb_event::byte_patched:
+      ev->ea1 = va_arg(va, ea_t);
+      ev->ea2 = ev->ea1 + 1;
+      break;
+
+    case idb_event::cmt_changed:
+      ev->ea1 = va_arg(va, ea_t);
+      ev->n = va_arg(va, int);
+      break;
+
+    case idb_event::area_cmt_changed:
+      {
+        va_arg(va, areacb_t *);
+        area_t *area = va_arg(va, area_t *);
+        const char *cmt = va_arg(va, char *);
+        ev->ea1 = area->startEA;
+        ev->ea2 = area->endEA;
+        ev->n = va_arg(va, int);
+        if ( text != NULL && cmt != NULL )
+          *text = cmt;
+      }
+      break;
+
+    case idb_event::ti_changed:
+      {
+        ev->ea1 = va_arg(va, ea_t);
+        const type_t *type = va_arg(va, type_t *);
+        const p_list *fields = va_arg(va, p_list *);
+        if ( text != NULL && type != NULL )
+          *text = (const char *)type;
+        if ( fnames != NULL && fields != NULL )
+          *fnames = (const char *)fields;
+      }
+      break;
+
+    case idb_event::op_ti_changed:
+      {
+        ev->ea1 = va_arg(va, ea_t);
+        ev->n = va_arg(va, int);
+        const type_t *type = va_arg(va, type_t *);
+        const p_list *fields = va_arg(va, p_list *);
+        if ( text != NULL && type != NULL )
+          *text = (const char *)type;
+        if ( fnames != NULL && fields != NULL )
+          *fnames = (const char *)fields;
+      }
+      break;
+
+    case idb_event::segm_deleted:
+      ev->ea1 = va_arg(va, ea_t);
+      break;
+
+    case idb_event::op_type_changed:
+      ev->ea1 = va_arg(va, ea_t);
+      ev->n = va_arg(va, int);
+      break;
+
+    case idb_event::enum_created:
+      ev->ea1 = va_arg(va, enum_t);
+      if ( text != NULL )
+      {
+        char buf[MAXNAMESIZE];
+        if ( get_enum_name(ev->ea1, buf, sizeof(buf)) > 0 )
+          *text = buf;
+      }
+      break;
+
+    case idb_event::enum_deleted:
+    case idb_event::enum_bf_changed:
+    case idb_event::enum_cmt_changed:
+      ev->ea1 = va_arg(va, enum_t);
+      break;
+
+#ifdef NO_OBSOLETE_FUNCS
+    case idb_event::enum_member_created:
+    case idb_event::enum_member_deleted:
+#else
+    case idb_event::enum_const_created:
+    case idb_event::enum_const_deleted:
+#endif
+      ev->ea1 = va_arg(va, enum_t);
+      ev->ea2 = va_arg(va, const_t);
+      break;
+
+    case idb_event::struc_created:
+    case idb_event::struc_deleted:
+    case idb_event::struc_cmt_changed:
+      ev->ea1 = va_arg(va, tid_t);
+      break;
+
+    case idb_event::struc_renamed:
+    case idb_event::struc_expanded:
+      ev->ea1 = va_arg(va, struc_t *)->id;
+      break;
+
+    case idb_event::struc_member_created:
+    case idb_event::struc_member_renamed:
+    case idb_event::struc_member_changed:
+      ev->ea1 = va_arg(va, struc_t *)->id;
+      ev->ea2 = va_arg(va, member_t *)->id;
+      break;
+
+    case idb_event::struc_member_deleted:
+      ev->ea1 = va_arg(va, struc_t *)->id;
+      ev->ea2 = va_arg(va, tid_t);
+      break;
+
+    case idb_event::thunk_func_created:
+    case idb_event::func_noret_changed:
+      ev->ea1 = va_arg(va, func_t *)->startEA;
+      break;
+
+    case idb_event::func_tail_appended:
+      ev->ea1 = va_arg(va, func_t *)->startEA;
+      ev->ea2 = va_arg(va, func_t *)->startEA;
+      break;
+
+    case idb_event::func_tail_removed:
+    case idb_event::tail_owner_changed:
+      ev->ea1 = va_arg(va, func_t *)->startEA;
+      ev->ea2 = va_arg(va, ea_t);
+      break;
+
+    case idb_event::segm_added:
+    case idb_event::segm_start_changed:
+    case idb_event::segm_end_changed:
+      ev->ea1 = va_arg(va, segment_t *)->startEA;
+      break;
+
+    case idb_event::segm_moved:
+      ev->ea1 = va_arg(va, ea_t);
+      ev->ea2 = va_arg(va, ea_t);
+      break;
+
+    default:
+      return false;
+  }
+  if ( text != NULL && text->empty() )
+  {
+    // The names of the structures and members
+    char buf[MAXNAMESIZE];
+    switch ( code )
+    {
+      case idb_event::struc_created:
+      case idb_event::struc_renamed:
+        if ( get_struc_name(ev->ea1, buf, sizeof(buf)) > 0 )
+          *text = buf;
+        break;
+
+      case idb_event::struc_member_created:
+      case idb_event::struc_member_renamed:
+        if ( get_member_name(ev->ea2, buf, sizeof(buf)) > 0 )
+          *text = buf;
+        break;
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void idb_batch_flush(idb_batch_t *batch)
+{
+  // Events raised by on_batch() are queued for the next flush
+  if ( batch->events.empty() || batch->flushing )
+    return;
+
   PYW_GIL_GET;
+  batch->flushing = true;
+  idb_batch_events_t events;
+  events.swap(batch->events);
+  batch->events.reserve(batch->max_events);
 
+  newref_t py_events(PyList_New(events.size()));
+  if ( py_events != NULL )
+  {
+    for ( size_t i = 0; i < events.size(); ++i )
+    {
+      const idb_batch_event_t &ev = events[i];
+      PyList_SET_ITEM(py_events.o, i, Py_BuildValue("(s" PY_FMT64 PY_FMT64 "i)",
+                                                    idb_hook_events[ev.idx].method,
+                                                    pyul_t(ev.ea1),
+                                                    pyul_t(ev.ea2),
+                                                    ev.n));
+    }
+    hook_timer_t timer("IDB_Hooks", "on_batch", batch->hooks);
+    try
+    {
+      batch->hooks->on_batch(py_events.o);
+    }
+    catch ( Swig::DirectorException &e )
+    {
+      msg("Exception in IDB Hook function: %s\n", e.getMessage());
+      if ( PyErr_Occurred() )
+        PyErr_Print();
+    }
+  }
+  batch->flushing = false;
+}
+
+//---------------------------------------------------------------------------
+// Queues an event, coalescing it with the previous one if possible
+static void idb_batch_add(idb_batch_t *batch, int code, va_list va)
+{
+  idb_batch_event_t ev;
+  if ( !get_idb_batch_event(&ev, code, va) )
+    return;
+  if ( !batch->events.empty() )
+  {
+    idb_batch_event_t &last = batch->events.back();
+    if ( last.idx == ev.idx && last.n == ev.n )
+    {
+      if ( code == idb_event::byte_patched )
+      {
+        // Extend the range of patched bytes
+        if ( ev.ea1 >= last.ea1 && ev.ea1 <= last.ea2 )
+        {
+          last.ea2 = qmax(last.ea2, ev.ea2);
+          return;
+        }
+      }
+      else if ( last.ea1 == ev.ea1 && last.ea2 == ev.ea2 )
+      {
+        return; // repeated event
+      }
+    }
+  }
+  batch->events.push_back(ev);
+  if ( batch->events.size() >= batch->max_events )
+    idb_batch_flush(batch);
+}
+
+//---------------------------------------------------------------------------
+// Flushes the queue when the auto-analysis queue gets empty
+static int idaapi idb_batch_idp_cb(void *ud, int code, va_list)
+{
+  if ( code == processor_t::auto_empty || code == processor_t::auto_empty_finally )
+    idb_batch_flush((idb_batch_t *)ud);
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+// Flushes the queue while the auto-analysis is idle
+static int idaapi idb_batch_timer_cb(void *ud)
+{
+  idb_batch_t *batch = (idb_batch_t *)ud;
+  if ( autoIsOk() )
+    idb_batch_flush(batch);
+  return batch->flush_ms;
+}
+
+//---------------------------------------------------------------------------
+idb_batch_t *idb_batch_create(IDB_Hooks *hooks, size_t max_events, int flush_ms)
+{
+  idb_batch_t *batch = new idb_batch_t();
+  batch->hooks = hooks;
+  batch->max_events = max_events;
+  batch->flush_ms = flush_ms;
+  batch->timer = NULL;
+  batch->flushing = false;
+  batch->events.reserve(max_events);
+  if ( !hook_to_notification_point(HT_IDP, idb_batch_idp_cb, batch) )
+  {
+    delete batch;
+    return NULL;
+  }
+  if ( flush_ms > 0 )
+    batch->timer = register_timer(flush_ms, idb_batch_timer_cb, batch);
+  return batch;
+}
+
+//---------------------------------------------------------------------------
+void idb_batch_free(idb_batch_t *batch)
+{
+  if ( batch == NULL )
+    return;
+  if ( batch->timer != NULL )
+    unregister_timer(batch->timer);
+  unhook_from_notification_point(HT_IDP, idb_batch_idp_cb, batch);
+  delete batch;
+}
+
+//---------------------------------------------------------------------------
+// Asynchronous mode of IDB_Hooks: the events are copied to a bounded queue,
+// and a worker thread delivers them to IDB_Hooks.on_batch(). The kernel
+// never takes the GIL: it only holds the queue lock for the copy.
+//---------------------------------------------------------------------------
+#define IDB_ASYNC_BLOCK_TIMEOUT 1000 // ms an IDBA_BLOCK producer waits for room
+
+struct idb_async_event_t
+{
+  idb_batch_event_t ev;
+  qstring text;
+  qstring fnames;   // type events only
+};
+DECLARE_TYPE_AS_MOVABLE(idb_async_event_t);
+typedef qvector<idb_async_event_t> idb_async_events_t;
+
+struct idb_async_t
+{
+  IDB_Hooks *hooks;
+  PyObject *py_self;            // kept alive while the worker may call it
+  int policy;
+  size_t max_batch;
+
+  // Ring buffer, protected by 'lock'
+  qmutex_t lock;
+  idb_async_events_t ring;
+  size_t head;                  // oldest event
+  size_t count;
+
+  qsemaphore_t has_events;      // posted when the ring stops being empty
+  qsemaphore_t has_room;        // posted after each batch, if 'nwaiting'
+  int nwaiting;                 // IDBA_BLOCK producers waiting for room
+  qthread_t thread;
+  volatile bool stopping;
+
+  // Counters, protected by 'lock'
+  uint64 nqueued;
+  uint64 ndelivered;
+  uint64 ndropped;
+  uint64 nblocked;
+  size_t max_depth;
+};
+
+//---------------------------------------------------------------------------
+// Moves up to 'max_batch' events from the ring to 'out'
+static void idb_async_pop(idb_async_t *q, idb_async_events_t *out)
+{
+  out->qclear();
+  qmutex_lock(q->lock);
+  size_t n = qmin(q->count, q->max_batch);
+  for ( size_t i = 0; i < n; ++i )
+  {
+    idb_async_event_t &src = q->ring[q->head];
+    out->push_back().ev = src.ev;
+    out->back().text.swap(src.text);
+    out->back().fnames.swap(src.fnames);
+    q->head = (q->head + 1) % q->ring.size();
+  }
+  q->count -= n;
+  bool wake = n != 0 && q->nwaiting > 0;
+  qmutex_unlock(q->lock);
+  if ( wake )
+    qsem_post(q->has_room);
+}
+
+//---------------------------------------------------------------------------
+// Runs on the worker thread
+static void idb_async_deliver(idb_async_t *q, const idb_async_events_t &events)
+{
+  PYW_GIL_GET;
+  newref_t py_events(PyList_New(events.size()));
+  if ( py_events == NULL )
+  {
+    PyErr_Print();
+    return;
+  }
+  for ( size_t i = 0; i < events.size(); ++i )
+  {
+    const idb_batch_event_t &ev = events[i].ev;
+    const qstring &text = events[i].text;
+    const qstring &fnames = events[i].fnames;
+    int code = idb_hook_events[ev.idx].code;
+    PyObject *py_text;
+    if ( text.empty() )
+    {
+      py_text = Py_None;
+      Py_INCREF(py_text);
+    }
+    else if ( code == idb_event::ti_changed || code == idb_event::op_ti_changed )
+    {
+      // The serialized type and field names, as for get_tinfo()
+      PyObject *py_fnames = Py_None;
+      if ( fnames.empty() )
+        Py_INCREF(py_fnames);
+      else
+        py_fnames = PyString_FromStringAndSize(fnames.c_str(), fnames.length());
+      py_text = Py_BuildValue("(NN)",
+                              PyString_FromStringAndSize(text.c_str(), text.length()),
+                              py_fnames);
+    }
+    else
+    {
+      py_text = PyString_FromStringAndSize(text.c_str(), text.length());
+    }
+    PyList_SET_ITEM(py_events.o, i, Py_BuildValue("(s" PY_FMT64 PY_FMT64 "iN)",
+                                                  idb_hook_events[ev.idx].method,
+                                                  pyul_t(ev.ea1),
+                                                  pyul_t(ev.ea2),
+                                                  ev.n,
+                                                  py_text));
+  }
+  hook_timer_t timer("IDB_Hooks", "on_batch", q->py_self);
+  try
+  {
+    q->hooks->on_batch(py_events.o);
+  }
+  catch ( Swig::DirectorException &e )
+  {
+    msg("Exception in IDB Hook function: %s\n", e.getMessage());
+    if ( PyErr_Occurred() )
+      PyErr_Print();
+  }
+}
+
+//---------------------------------------------------------------------------
+static int idaapi idb_async_thread_cb(void *ud)
+{
+  idb_async_t *q = (idb_async_t *)ud;
+  idb_async_events_t events;
+  while ( true )
+  {
+    // Drain the queue completely before waiting again
+    idb_async_pop(q, &events);
+    if ( events.empty() )
+    {
+      if ( q->stopping )
+        break;
+      qsem_wait(q->has_events, -1);
+      continue;
+    }
+    idb_async_deliver(q, events);
+    qmutex_lock(q->lock);
+    q->ndelivered += events.size();
+    qmutex_unlock(q->lock);
+  }
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+// Waits for room in the ring. Called with 'lock' held, which is released
+// while waiting, and so is the GIL if this thread holds it (a Python script
+// modifying the database): the worker thread needs it to make room.
+// Returns false on timeout.
+static bool idb_async_wait_room(idb_async_t *q)
+{
+  PyThreadState *tstate = PyGILState_GetThisThreadState();
+  bool has_gil = tstate != NULL && tstate == _PyThreadState_Current;
+  if ( has_gil )
+    PyEval_SaveThread();
+  ++q->nwaiting;
+  ++q->nblocked;
+  uint64 deadline = get_nsec_stamp() + uint64(IDB_ASYNC_BLOCK_TIMEOUT) * 1000000;
+  while ( q->count == q->ring.size() && !q->stopping )
+  {
+    uint64 now = get_nsec_stamp();
+    if ( now >= deadline )
+      break;
+    qmutex_unlock(q->lock);
+    qsem_wait(q->has_room, int((deadline - now) / 1000000) + 1);
+    qmutex_lock(q->lock);
+  }
+  --q->nwaiting;
+  bool ok = q->count < q->ring.size();
+  if ( has_gil )
+  {
+    // Don't hold our lock while we wait for the GIL
+    qmutex_unlock(q->lock);
+    PyEval_RestoreThread(tstate);
+    qmutex_lock(q->lock);
+    ok = q->count < q->ring.size();
+  }
+  return ok;
+}
+
+//---------------------------------------------------------------------------
+// Queues an event. Called by the kernel, without the GIL.
+static void idb_async_add(idb_async_t *q, int code, va_list va)
+{
+  idb_async_event_t ev;
+  if ( !get_idb_batch_event(&ev.ev, code, va, &ev.text, &ev.fnames) )
+    return;
+
+  qmutex_lock(q->lock);
+  bool was_empty = q->count == 0;
+  if ( q->count == q->ring.size() )
+  {
+    if ( q->policy == IDBA_DROP_OLD )
+    {
+      q->head = (q->head + 1) % q->ring.size();
+      --q->count;
+      ++q->ndropped;
+    }
+    else if ( q->policy != IDBA_BLOCK || !idb_async_wait_room(q) )
+    {
+      ++q->ndropped;
+      qmutex_unlock(q->lock);
+      return;
+    }
+    was_empty = q->count == 0;
+  }
+  idb_async_event_t &slot = q->ring[(q->head + q->count) % q->ring.size()];
+  slot.ev = ev.ev;
+  slot.text.swap(ev.text);
+  slot.fnames.swap(ev.fnames);
+  ++q->count;
+  ++q->nqueued;
+  if ( q->count > q->max_depth )
+    q->max_depth = q->count;
+  qmutex_unlock(q->lock);
+
+  if ( was_empty )
+    qsem_post(q->has_events);
+}
+
+//---------------------------------------------------------------------------
+static void idb_async_destroy(idb_async_t *q)
+{
+  if ( q->has_room != NULL )
+    qsem_free(q->has_room);
+  if ( q->has_events != NULL )
+    qsem_free(q->has_events);
+  if ( q->lock != NULL )
+    qmutex_free(q->lock);
+  delete q;
+}
+
+//---------------------------------------------------------------------------
+// Must be called with the GIL
+idb_async_t *idb_async_create(IDB_Hooks *hooks, size_t capacity, int policy, size_t max_batch)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( policy < IDBA_DROP_NEW || policy > IDBA_BLOCK )
+    return NULL;
+  idb_async_t *q = new idb_async_t();
+  q->hooks = hooks;
+  q->py_self = get_director_self(hooks);
+  q->policy = policy;
+  q->max_batch = qmax(max_batch, size_t(1));
+  q->ring.resize(capacity);
+  q->head = q->count = 0;
+  q->nwaiting = 0;
+  q->stopping = false;
+  q->nqueued = q->ndelivered = q->ndropped = q->nblocked = 0;
+  q->max_depth = 0;
+  q->lock = qmutex_create();
+  q->has_events = qsem_create(NULL, 0);
+  q->has_room = qsem_create(NULL, 0);
+  q->thread = NULL;
+  if ( q->lock != NULL && q->has_events != NULL && q->has_room != NULL )
+    q->thread = qthread_create(idb_async_thread_cb, q);
+  if ( q->thread == NULL )
+  {
+    idb_async_destroy(q);
+    return NULL;
+  }
+  Py_XINCREF(q->py_self);
+  return q;
+}
+
+//---------------------------------------------------------------------------
+// Delivers the queued events, stops the worker thread and frees the queue.
+// Must be called with the GIL. Fails if called from on_batch().
+bool idb_async_free(idb_async_t *q)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( q == NULL )
+    return true;
+  if ( qthread_same(q->thread) )
+    return false; // we would wait for ourselves
+  q->stopping = true;
+  qsem_post(q->has_events);
+  // The worker needs the GIL to deliver the last events
+  Py_BEGIN_ALLOW_THREADS;
+  qthread_join(q->thread);
+  Py_END_ALLOW_THREADS;
+  qthread_free(q->thread);
+  Py_XDECREF(q->py_self);
+  idb_async_destroy(q);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+PyObject *idb_async_get_stats(const idb_async_t *q)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( q == NULL )
+    Py_RETURN_NONE;
+  qmutex_lock(q->lock);
+  PyObject *py_stats = Py_BuildValue("{s:K,s:K,s:K,s:K,s:n,s:n}",
+                                     "queued", (unsigned PY_LONG_LONG)q->nqueued,
+                                     "delivered", (unsigned PY_LONG_LONG)q->ndelivered,
+                                     "dropped", (unsigned PY_LONG_LONG)q->ndropped,
+                                     "blocked", (unsigned PY_LONG_LONG)q->nblocked,
+                                     "max_depth", Py_ssize_t(q->max_depth),
+                                     "depth", Py_ssize_t(q->count));
+  qmutex_unlock(q->lock);
+  return py_stats;
+}
+
+//---------------------------------------------------------------------------
+int idaapi IDB_Callback(void *ud, int notification_code, va_list va)
+{
   class IDB_Hooks *proxy = (class IDB_Hooks *)ud;
+
+  // Asynchronous mode: queue the event for the worker thread
+  if ( proxy->async != NULL )
+  {
+    idb_async_add(proxy->async, notification_code, va);
+    return 0;
+  }
+
+  // Batch mode: queue the event, on_batch() will get it
+  if ( proxy->batch != NULL )
+  {
+    idb_batch_add(proxy->batch, notification_code, va);
+    return 0;
+  }
+
+  // Don't take the GIL for the events the Python class doesn't handle
+  int idx = find_hook_event(idb_hook_events, qnumber(idb_hook_events), notification_code);
+  if ( idx < 0 || (proxy->overridden & (uint64(1) << idx)) == 0 )
+    return 0;
+
+  // This hook gets called from the kernel. Ensure we hold the GIL.
+  PYW_GIL_GET;
+  hook_timer_t timer("IDB_Hooks", notification_code, proxy);
   ea_t ea, ea2;
   bool repeatable_cmt;
   type_t *type;
@@ -801,11 +801,16 @@ def execute_sync(callable, reqf):
     If the current thread not the main thread, then the call is queued and
     executed afterwards.
 
-    @note: The Python version of execute_sync() cannot be called from a different thread
-           for the time being.
+    @note: It can be called from threading.Thread threads. It releases
+           the GIL while the request is queued, but the main thread must
+           not wait for the calling thread in the meantime (with join(),
+           for example), or they will deadlock.
+           If the callable raises an exception, it is printed and -1 is
+           returned. Use execute_async() to get any result, or the
+           exception, back.
     @param callable: A python callable object
     @param reqf: one of MFF_ flags
-    @return: -1 or the return value of the callable
+    @return: -1 or the return value of the callable, if it is an integer
     """
     pass
 #</pydoc>
@@ -825,6 +830,9 @@ static int py_execute_sync(PyObject *py_callable, int reqf)
       {
         PYW_GIL_GET;
         newref_t py_result(PyObject_CallFunctionObjArgs(py_callable.o, NULL));
+        // Don't leave the exception pending on the main thread
+        if ( py_result == NULL )
+          PyErr_Print();
         int ret = py_result == NULL || !PyInt_Check(py_result.o)
                 ? -1
                 : PyInt_AsLong(py_result.o);
@@ -864,6 +872,112 @@ static int py_execute_sync(PyObject *py_callable, int reqf)
   return rc;
 }
 
+//------------------------------------------------------------------------
+/*
+#<pydoc>
+def py_execute_async(calls, reqf):
+    """
+    Internal: executes the callables on the main thread, in one request,
+    and passes their results to their futures. See execute_async().
+
+    @param calls: a list of (callable, future) tuples
+    @param reqf: one of MFF_ flags (MFF_NOWAIT is implied)
+    @return: Boolean. False if the list is invalid
+    """
+    pass
+#</pydoc>
+*/
+static bool py_execute_async(PyObject *py_calls, int reqf)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( !PyList_Check(py_calls) )
+    return false;
+  Py_ssize_t n = PyList_Size(py_calls);
+  for ( Py_ssize_t i = 0; i < n; ++i )
+  {
+    PyObject *py_item = PyList_GET_ITEM(py_calls, i);
+    if ( !PyTuple_Check(py_item)
+      || PyTuple_Size(py_item) != 2
+      || !PyCallable_Check(PyTuple_GET_ITEM(py_item, 0)) )
+    {
+      return false;
+    }
+  }
+  if ( n == 0 )
+    return true;
+
+  struct py_async_request_t : exec_request_t
+  {
+    ref_t py_calls;
+
+    // Passes the result of a call, or its exception, to the future
+    static void resolve(PyObject *py_future, PyObject *py_result)
+    {
+      if ( py_result != NULL )
+      {
+        newref_t py_ret(PyObject_CallMethod(py_future, (char *)"_set_result", (char *)"(O)", py_result));
+        if ( py_ret == NULL )
+          PyErr_Print();
+        return;
+      }
+      PyObject *py_type, *py_value, *py_tb;
+      PyErr_Fetch(&py_type, &py_value, &py_tb);
+      PyErr_NormalizeException(&py_type, &py_value, &py_tb);
+      newref_t py_ret(PyObject_CallMethod(
+                        py_future,
+                        (char *)"_set_exception",
+                        (char *)"(OOO)",
+                        py_type,
+                        py_value != NULL ? py_value : Py_None,
+                        py_tb != NULL ? py_tb : Py_None));
+      if ( py_ret == NULL )
+        PyErr_Print();
+      Py_XDECREF(py_type);
+      Py_XDECREF(py_value);
+      Py_XDECREF(py_tb);
+    }
+
+    virtual int idaapi execute()
+    {
+      {
+        PYW_GIL_GET;
+        Py_ssize_t n = PyList_Size(py_calls.o);
+        for ( Py_ssize_t i = 0; i < n; ++i )
+        {
+          PyObject *py_item = PyList_GET_ITEM(py_calls.o, i);
+          newref_t py_result(PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(py_item, 0), NULL));
+          resolve(PyTuple_GET_ITEM(py_item, 1), py_result.o);
+        }
+      }
+      // Nobody waits for us: self-destroy
+      delete this;
+      return 0;
+    }
+    py_async_request_t(PyObject *py_list)
+    {
+      // Our own copy: the caller may modify the list
+      py_calls = newref_t(PyList_GetSlice(py_list, 0, PyList_Size(py_list)));
+    }
+    virtual ~py_async_request_t()
+    {
+      // Might be called from the main thread
+      PYW_GIL_GET;
+      py_calls = ref_t();
+    }
+  };
+  py_async_request_t *req = new py_async_request_t(py_calls);
+  if ( req->py_calls == NULL )
+  {
+    delete req;
+    PyErr_Clear();
+    return false;
+  }
+  Py_BEGIN_ALLOW_THREADS;
+  execute_sync(*req, reqf | MFF_NOWAIT);
+  Py_END_ALLOW_THREADS;
+  return true;
+}
+
 //------------------------------------------------------------------------
 /*
 #<pydoc>
@@ -1464,6 +1578,14 @@ PyObject *choose2_get_embedded(PyObject *self);
 PyObject *choose2_get_embedded_selection(PyObject *self);
 
 
+PyObject *idle_scheduler_create(int budget_ms, bool pause_on_analysis);
+int idle_scheduler_add(PyObject *py_sched, PyObject *py_job, int priority, const char *name);
+bool idle_scheduler_remove(PyObject *py_sched, int job_id);
+void idle_scheduler_pause(PyObject *py_sched, bool pause);
+void idle_scheduler_reset_stats(PyObject *py_sched);
+PyObject *idle_scheduler_get_stats(PyObject *py_sched);
+
+
 #define DECLARE_FORM_ACTIONS form_actions_t *fa = (form_actions_t *)p_fa;
 
 //---------------------------------------------------------------------------
@@ -1854,6 +1976,7 @@ int idaapi UI_Callback(void *ud, int notification_code, va_list va)
   // This hook gets called from the kernel. Ensure we hold the GIL.
   PYW_GIL_GET;
   UI_Hooks *proxy = (UI_Hooks *)ud;
+  hook_timer_t timer("UI_Hooks", notification_code, proxy);
   int ret = 0;
   try
   {
@@ -2203,7 +2326,10 @@ private:
 
     // Call Python
     PYW_GIL_CHECK_LOCKED_SCOPE();
-    pycall_res_t list(PyObject_CallMethod(self, (char *)S_ON_GET_LINE, "i", lineno - 1));
+    hook_timer_t timer("Choose2", S_ON_GET_LINE, self);
+    static py_method_t on_get_line_m(S_ON_GET_LINE);
+    newref_t py_lineno(PyInt_FromLong(lineno - 1));
+    pycall_res_t list(on_get_line_m.call(self, py_lineno.o, NULL));
     if ( list.result == NULL )
       return;
 
@@ -2223,7 +2349,9 @@ private:
   size_t on_get_size()
   {
     PYW_GIL_GET;
-    pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_GET_SIZE, NULL));
+    hook_timer_t timer("Choose2", S_ON_GET_SIZE, self);
+    static py_method_t on_get_size_m(S_ON_GET_SIZE);
+    pycall_res_t pyres(on_get_size_m.call(self, NULL));
     if ( pyres.result == NULL )
       return 0;
 
@@ -2233,12 +2361,14 @@ private:
   void on_refreshed()
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_REFRESHED, self);
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_REFRESHED, NULL));
   }
 
   void on_select(const intvec_t &intvec)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_SELECTION_CHANGE, self);
     ref_t py_list(PyW_IntVecToPyList(intvec));
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_SELECTION_CHANGE, "O", py_list.o));
   }
@@ -2246,6 +2376,7 @@ private:
   void on_close()
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_CLOSE, self);
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_CLOSE, NULL));
 
     // Delete this instance if none modal and not embedded
@@ -2256,6 +2387,7 @@ private:
   int on_delete_line(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_DELETE_LINE, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -2268,6 +2400,7 @@ private:
   int on_refresh(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_REFRESH, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -2280,12 +2413,14 @@ private:
   void on_insert_line()
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_INSERT_LINE, self);
     pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_INSERT_LINE, NULL));
   }
 
   void on_enter(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_SELECT_LINE, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -2297,6 +2432,7 @@ private:
   void on_edit_line(int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_EDIT_LINE, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -2308,6 +2444,7 @@ private:
   int on_command(int cmd_id, int lineno)
   {
     PYW_GIL_GET;
+    hook_timer_t timer("Choose2", S_ON_COMMAND, self);
     pycall_res_t pyres(
             PyObject_CallMethod(
                     self,
@@ -2321,19 +2458,20 @@ private:
   int on_get_icon(int lineno)
   {
     PYW_GIL_GET;
-    pycall_res_t pyres(
-            PyObject_CallMethod(
-                    self,
-                    (char *)S_ON_GET_ICON,
-                    "i",
-                    lineno - 1));
+    hook_timer_t timer("Choose2", S_ON_GET_ICON, self);
+    static py_method_t on_get_icon_m(S_ON_GET_ICON);
+    newref_t py_lineno(PyInt_FromLong(lineno - 1));
+    pycall_res_t pyres(on_get_icon_m.call(self, py_lineno.o, NULL));
     return PyInt_AsLong(pyres.result.o);
   }
 
   void on_get_line_attr(int lineno, chooser_item_attrs_t *attr)
   {
     PYW_GIL_GET;
-    pycall_res_t pyres(PyObject_CallMethod(self, (char *)S_ON_GET_LINE_ATTR, "i", lineno - 1));
+    hook_timer_t timer("Choose2", S_ON_GET_LINE_ATTR, self);
+    static py_method_t on_get_line_attr_m(S_ON_GET_LINE_ATTR);
+    newref_t py_lineno(PyInt_FromLong(lineno - 1));
+    pycall_res_t pyres(on_get_line_attr_m.call(self, py_lineno.o, NULL));
     if ( pyres.result != NULL )
     {
       if ( PyList_Check(pyres.result.o) )
@@ -2845,6 +2983,392 @@ PyObject *choose2_find(const char *title)
 }
 
 
+//---------------------------------------------------------------------------
+// Idle scheduler: runs Python iterators ("jobs", usually generators) from
+// UI requests. Every UI loop iteration gets one time slice, during which
+// the jobs are advanced one next() ("unit of work") at a time, highest
+// priority first, and round-robin among equal priorities.
+//---------------------------------------------------------------------------
+#define IDLE_SCHED_POLL_MS 200 // how often we check if the auto-analysis is done
+
+enum idle_job_state_t
+{
+  IJS_QUEUED,
+  IJS_DONE,
+  IJS_FAILED,           // the iterator raised an exception
+  IJS_REMOVED,
+};
+
+struct idle_job_t
+{
+  int id;
+  int priority;
+  idle_job_state_t state;
+  qstring name;
+  ref_t py_iter;        // NULL once the job is over
+  uint64 last_run;      // for round-robin
+  uint64 last_slice;    // last slice that advanced this job
+  uint64 units;
+  uint64 slices;
+  uint64 busy_ns;       // time spent in next()
+  uint64 added_ns;
+  uint64 ended_ns;
+};
+typedef qvector<idle_job_t *> idle_jobs_t;
+
+//---------------------------------------------------------------------------
+class idle_scheduler_t
+{
+  struct request_t : public ui_request_t
+  {
+    idle_scheduler_t *sched;    // NULL if the scheduler is gone
+    request_t(idle_scheduler_t *_sched) : sched(_sched) {}
+    virtual bool idaapi run()
+    {
+      return sched != NULL && sched->run_slice();
+    }
+  };
+
+  idle_jobs_t jobs;             // queued jobs first, then the finished ones
+  size_t nqueued;
+  request_t *req;               // pending UI request, or NULL
+  qtimer_t timer;               // waiting for the auto-analysis, or NULL
+  int budget_ms;
+  bool pause_on_analysis;
+  bool paused;
+  bool running;                 // in run_slice()
+  bool doomed;                  // destroy() was called from a job
+  bool reset_pending;           // reset_stats() was called from a job
+  int next_id;
+  uint64 counter;               // for idle_job_t::last_run
+  uint64 nslices;
+
+  //-------------------------------------------------------------------------
+  static int idaapi timer_cb(void *ud)
+  {
+    idle_scheduler_t *_this = (idle_scheduler_t *)ud;
+    if ( !autoIsOk() )
+      return IDLE_SCHED_POLL_MS;
+    _this->timer = NULL;
+    _this->schedule();
+    return -1;
+  }
+
+  //-------------------------------------------------------------------------
+  // Highest priority, least recently run queued job
+  idle_job_t *pick() const
+  {
+    idle_job_t *best = NULL;
+    for ( size_t i = 0; i < nqueued; ++i )
+    {
+      idle_job_t *job = jobs[i];
+      if ( best == NULL
+        || job->priority > best->priority
+        || (job->priority == best->priority && job->last_run < best->last_run) )
+      {
+        best = job;
+      }
+    }
+    return best;
+  }
+
+  //-------------------------------------------------------------------------
+  // Moves a queued job to the finished ones. Must be called with the GIL.
+  void finish(idle_job_t *job, idle_job_state_t state)
+  {
+    if ( job->state != IJS_QUEUED )
+      return;
+    job->state = state;
+    job->ended_ns = get_nsec_stamp();
+    job->py_iter = ref_t();
+    idle_jobs_t::iterator p = jobs.find(job);
+    jobs.erase(p);
+    jobs.insert(jobs.begin() + --nqueued, job);
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  void run_unit(idle_job_t *job)
+  {
+    job->last_run = ++counter;
+    if ( job->last_slice != nslices )
+    {
+      job->last_slice = nslices;
+      ++job->slices;
+    }
+    // The job may remove itself (or others) from the scheduler
+    ref_t py_iter = job->py_iter;
+    uint64 t0 = get_nsec_stamp();
+    newref_t py_item(PyIter_Next(py_iter.o));
+    job->busy_ns += get_nsec_stamp() - t0;
+    if ( py_item != NULL )
+    {
+      ++job->units;
+    }
+    else if ( PyErr_Occurred() )
+    {
+      msg("IDAPython: idle job \"%s\" failed:\n", job->name.c_str());
+      PyErr_Print();
+      finish(job, IJS_FAILED);
+    }
+    else
+    {
+      finish(job, IJS_DONE);
+    }
+  }
+
+  //-------------------------------------------------------------------------
+  // Called from the UI request. Returns true to be called again.
+  bool run_slice()
+  {
+    if ( running )
+      return true; // a job is processing the UI events: wait for it
+    if ( paused || nqueued == 0 )
+    {
+      req = NULL;
+      return false;
+    }
+    if ( pause_on_analysis && !autoIsOk() )
+    {
+      req = NULL;
+      schedule();
+      return false;
+    }
+
+    PYW_GIL_GET;
+    running = true;
+    ++nslices;
+    uint64 deadline = get_nsec_stamp() + uint64(budget_ms) * 1000000;
+    do
+    {
+      idle_job_t *job = pick();
+      if ( job == NULL )
+        break;
+      run_unit(job);
+    }
+    while ( !paused && !doomed && get_nsec_stamp() < deadline );
+    running = false;
+    if ( reset_pending )
+      reset_stats();
+
+    if ( doomed )
+    {
+      req = NULL;
+      delete this;
+      return false;
+    }
+    if ( paused || nqueued == 0 )
+    {
+      req = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  //-------------------------------------------------------------------------
+  // Queues a UI request if there is work to do
+  void schedule()
+  {
+    if ( paused || req != NULL || timer != NULL || nqueued == 0 )
+      return;
+    if ( pause_on_analysis && !autoIsOk() )
+    {
+      timer = register_timer(IDLE_SCHED_POLL_MS, timer_cb, this);
+      return;
+    }
+    req = new request_t(this);
+    execute_ui_requests(req, NULL);
+  }
+
+  //-------------------------------------------------------------------------
+  ~idle_scheduler_t()
+  {
+    if ( req != NULL )
+      req->sched = NULL; // the kernel will delete it
+    if ( timer != NULL )
+      unregister_timer(timer);
+    for ( size_t i = 0; i < jobs.size(); ++i )
+      delete jobs[i];
+  }
+
+public:
+  idle_scheduler_t(int _budget_ms, bool _pause_on_analysis)
+    : nqueued(0), req(NULL), timer(NULL),
+      budget_ms(qmax(_budget_ms, 1)), pause_on_analysis(_pause_on_analysis),
+      paused(false), running(false), doomed(false), reset_pending(false),
+      next_id(1), counter(0), nslices(0) {}
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  void destroy()
+  {
+    if ( running )
+      doomed = true; // run_slice() will delete us
+    else
+      delete this;
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  int add(PyObject *py_iter, int priority, const char *name)
+  {
+    idle_job_t *job = new idle_job_t();
+    job->id = next_id++;
+    job->priority = priority;
+    job->state = IJS_QUEUED;
+    job->name = name != NULL ? name : "";
+    job->py_iter = borref_t(py_iter);
+    job->last_run = 0; // new jobs go first
+    job->last_slice = 0;
+    job->units = job->slices = job->busy_ns = 0;
+    job->added_ns = get_nsec_stamp();
+    job->ended_ns = 0;
+    jobs.insert(jobs.begin() + nqueued++, job);
+    schedule();
+    return job->id;
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  bool remove(int id)
+  {
+    for ( size_t i = 0; i < nqueued; ++i )
+    {
+      if ( jobs[i]->id == id )
+      {
+        finish(jobs[i], IJS_REMOVED);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //-------------------------------------------------------------------------
+  void pause(bool pause)
+  {
+    paused = pause;
+    if ( !paused )
+      schedule();
+  }
+
+  //-------------------------------------------------------------------------
+  // Forgets the finished jobs. Must be called with the GIL.
+  void reset_stats()
+  {
+    // The running job may be one of them
+    reset_pending = running;
+    if ( reset_pending )
+      return;
+    for ( size_t i = nqueued; i < jobs.size(); ++i )
+      delete jobs[i];
+    jobs.resize(nqueued);
+  }
+
+  //-------------------------------------------------------------------------
+  // Must be called with the GIL
+  PyObject *get_stats() const
+  {
+    static const char *const states[] = { "queued", "done", "failed", "removed" };
+    newref_t py_list(PyList_New(jobs.size()));
+    if ( py_list == NULL )
+      return NULL;
+    uint64 now = get_nsec_stamp();
+    for ( size_t i = 0; i < jobs.size(); ++i )
+    {
+      const idle_job_t *job = jobs[i];
+      double busy_s = job->busy_ns / 1e9;
+      PyObject *py_job = Py_BuildValue(
+              "{s:i,s:s,s:i,s:s,s:K,s:K,s:K,s:K,s:d}",
+              "id", job->id,
+              "name", job->name.c_str(),
+              "priority", job->priority,
+              "state", states[job->state],
+              "units", (unsigned PY_LONG_LONG)job->units,
+              "slices", (unsigned PY_LONG_LONG)job->slices,
+              "busy_ns", (unsigned PY_LONG_LONG)job->busy_ns,
+              "elapsed_ns", (unsigned PY_LONG_LONG)((job->state == IJS_QUEUED ? now : job->ended_ns) - job->added_ns),
+              "units_per_sec", busy_s > 0 ? job->units / busy_s : 0.0);
+      if ( py_job == NULL )
+        return NULL;
+      PyList_SET_ITEM(py_list.o, i, py_job);
+    }
+    py_list.incref();
+    return py_list.o;
+  }
+};
+
+//---------------------------------------------------------------------------
+static void idaapi idle_scheduler_free(void *ptr)
+{
+  ((idle_scheduler_t *)ptr)->destroy();
+}
+
+//---------------------------------------------------------------------------
+static idle_scheduler_t *get_idle_scheduler(PyObject *py_sched)
+{
+  if ( !PyCObject_Check(py_sched) )
+  {
+    PyErr_SetString(PyExc_TypeError, "Expected an idle scheduler");
+    return NULL;
+  }
+  return (idle_scheduler_t *)PyCObject_AsVoidPtr(py_sched);
+}
+
+//---------------------------------------------------------------------------
+PyObject *idle_scheduler_create(int budget_ms, bool pause_on_analysis)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = new idle_scheduler_t(budget_ms, pause_on_analysis);
+  return PyCObject_FromVoidPtr(sched, idle_scheduler_free);
+}
+
+//---------------------------------------------------------------------------
+int idle_scheduler_add(PyObject *py_sched, PyObject *py_job, int priority, const char *name)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched == NULL || !PyIter_Check(py_job) )
+    return -1;
+  return sched->add(py_job, priority, name);
+}
+
+//---------------------------------------------------------------------------
+bool idle_scheduler_remove(PyObject *py_sched, int job_id)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  return sched != NULL && sched->remove(job_id);
+}
+
+//---------------------------------------------------------------------------
+void idle_scheduler_pause(PyObject *py_sched, bool pause)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched != NULL )
+    sched->pause(pause);
+}
+
+//---------------------------------------------------------------------------
+void idle_scheduler_reset_stats(PyObject *py_sched)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched != NULL )
+    sched->reset_stats();
+}
+
+//---------------------------------------------------------------------------
+PyObject *idle_scheduler_get_stats(PyObject *py_sched)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  idle_scheduler_t *sched = get_idle_scheduler(py_sched);
+  if ( sched == NULL )
+    return NULL;
+  return sched->get_stats();
+}
+
+
 void free_compiled_form_instances(void)
 {
   while ( !py_compiled_form_vec.empty() )
@@ -2955,16 +3479,21 @@ private:
     int shift)
   {
     PYW_GIL_GET;
+    static py_method_t on_keydown_m(S_ON_KEYDOWN);
+    newref_t py_line(PyString_FromString(line->c_str()));
+    newref_t py_x(PyInt_FromLong(*p_x));
+    newref_t py_sellen(PyInt_FromLong(*p_sellen));
+    newref_t py_vk_key(PyInt_FromLong(*vk_key & 0xffff));
+    newref_t py_shift(PyInt_FromLong(shift));
     newref_t result(
-            PyObject_CallMethod(
+            on_keydown_m.call(
                     self,
-                    (char *)S_ON_KEYDOWN,
-                    "siiHi",
-                    line->c_str(),
-                    *p_x,
-                    *p_sellen,
-                    *vk_key,
-                    shift));
+                    py_line.o,
+                    py_x.o,
+                    py_sellen.o,
+                    py_vk_key.o,
+                    py_shift.o,
+                    NULL));
 
     bool ok = result != NULL && PyTuple_Check(result.o);
 
@@ -3010,15 +3539,19 @@ private:
           int x)
   {
     PYW_GIL_GET;
+    static py_method_t on_complete_line_m(S_ON_COMPLETE_LINE);
+    newref_t py_prefix(PyString_FromString(prefix));
+    newref_t py_n(PyInt_FromLong(n));
+    newref_t py_line(PyString_FromString(line));
+    newref_t py_x(PyInt_FromLong(x));
     newref_t result(
-            PyObject_CallMethod(
+            on_complete_line_m.call(
                     self,
-                    (char *)S_ON_COMPLETE_LINE,
-                    "sisi",
-                    prefix,
-                    n,
-                    line,
-                    x));
+                    py_prefix.o,
+                    py_n.o,
+                    py_line.o,
+                    py_x.o,
+                    NULL));
 
     bool ok = result != NULL && PyString_Check(result.o);
     PyW_ShowCbErr(S_ON_COMPLETE_LINE);
@@ -4596,6 +5129,96 @@ class action_handler_t:
     def update(self, ctx):
         pass
 
+# ----------------------------------------------------------------------
+class execute_future_t(object):
+    """
+    Result of a callable queued with execute_async()
+    """
+    def __init__(self):
+        import threading
+        self._done = threading.Event()
+        self._result = None
+        self._exc_info = None
+
+    def _set_result(self, result):
+        self._result = result
+        self._done.set()
+
+    def _set_exception(self, type, value, tb):
+        self._exc_info = (type, value, tb)
+        self._done.set()
+
+    def done(self):
+        """Returns True if the callable was executed"""
+        return self._done.is_set()
+
+    def wait(self, timeout=None):
+        """
+        Waits for the callable to be executed.
+        Must not be called from the main thread (which executes it).
+
+        @param timeout: in seconds, or None to wait forever
+        @return: Boolean. False on timeout
+        """
+        if not self._done.is_set():
+            import threading
+            if isinstance(threading.current_thread(), threading._MainThread):
+                raise RuntimeError("Cannot wait for execute_async() on the main thread")
+            self._done.wait(timeout)
+        return self._done.is_set()
+
+    def result(self, timeout=None):
+        """
+        Waits for the callable, and returns its result, or raises its exception.
+        Raises RuntimeError on timeout.
+        """
+        if not self.wait(timeout):
+            raise RuntimeError("execute_async() timed out")
+        if self._exc_info is not None:
+            raise self._exc_info[0], self._exc_info[1], self._exc_info[2]
+        return self._result
+
+    def exception(self, timeout=None):
+        """
+        Waits for the callable, and returns the exception it raised, or None.
+        Raises RuntimeError on timeout.
+        """
+        if not self.wait(timeout):
+            raise RuntimeError("execute_async() timed out")
+        return None if self._exc_info is None else self._exc_info[1]
+
+# ----------------------------------------------------------------------
+def execute_async_batch(callables, reqf=MFF_WRITE):
+    """
+    Executes callables in the context of the main thread, in the order
+    of the list, during a single request, without waiting for them.
+    Can be called from any thread.
+
+    @param callables: a list of python callable objects
+    @param reqf: one of MFF_ flags (MFF_NOWAIT is implied)
+    @return: a list of execute_future_t objects, one per callable
+    """
+    callables = list(callables)
+    futures = [execute_future_t() for c in callables]
+    if not _idaapi.py_execute_async(zip(callables, futures), reqf):
+        raise ValueError("Expected a list of callables")
+    return futures
+
+# ----------------------------------------------------------------------
+def execute_async(callable, reqf=MFF_WRITE):
+    """
+    Executes a callable in the context of the main thread, without waiting
+    for it. Can be called from any thread.
+    execute_async(f).result() is like execute_sync(f, reqf), except that
+    the result can be any Python object, and the exception raised by the
+    callable, if any, is raised again.
+
+    @param callable: a python callable object
+    @param reqf: one of MFF_ flags (MFF_NOWAIT is implied)
+    @return: an execute_future_t object
+    """
+    return execute_async_batch([callable], reqf)[0]
+
 
 
 class Choose2(object):
@@ -4837,6 +5460,88 @@ class Choose2(object):
 #</pydoc>
 
 
+class IdleScheduler(object):
+    """
+    Runs background jobs on the main thread, in time slices, while the
+    user interface stays responsive.
+
+    A job is an iterable, usually a generator, that yields between its
+    units of work. Every UI loop iteration gives the scheduler one time
+    slice of 'budget_ms' milliseconds, during which the jobs are advanced
+    one unit at a time: highest priority first, round-robin among the
+    jobs of equal priority.
+
+    Example:
+        def rename_all():
+            for ea in Functions():
+                ...
+                yield
+
+        sched = IdleScheduler(budget_ms = 10)
+        sched.add(rename_all())
+
+    The jobs stop when the scheduler is deleted: keep a reference to it.
+    """
+    def __init__(self, budget_ms = 20, pause_on_analysis = True):
+        """
+        @param budget_ms: length of the time slices
+        @param pause_on_analysis: do not run the jobs while the
+                                  auto-analysis is busy
+        """
+        self.__sched = _idaapi.idle_scheduler_create(budget_ms, pause_on_analysis)
+
+    def add(self, job, priority = 0, name = None):
+        """
+        Queues a job.
+
+        @param job: an iterable (a generator, ...). Each value it produces
+                    ends a unit of work, and the values are ignored.
+        @param priority: the jobs with the highest priority run first
+        @param name: name of the job in the statistics
+        @return: the job id
+        """
+        if name is None:
+            name = getattr(job, "__name__", None) or type(job).__name__
+        return _idaapi.idle_scheduler_add(self.__sched, iter(job), priority, name)
+
+    def remove(self, job_id):
+        """
+        Removes a queued job.
+
+        @return: Boolean. False if the job is not queued anymore
+        """
+        return _idaapi.idle_scheduler_remove(self.__sched, job_id)
+
+    def pause(self):
+        """Stops running the jobs, until resume()"""
+        _idaapi.idle_scheduler_pause(self.__sched, True)
+
+    def resume(self):
+        """Runs the jobs again after pause()"""
+        _idaapi.idle_scheduler_pause(self.__sched, False)
+
+    def get_stats(self):
+        """
+        Returns the statistics of the jobs, as a list of dictionaries with
+        the following keys:
+          - id, name, priority
+          - state: 'queued', 'done', 'failed' (it raised an exception)
+                   or 'removed'
+          - units: number of units of work done
+          - slices: number of time slices the job ran in
+          - busy_ns: time spent in the job
+          - elapsed_ns: time since the job was added, until it ended
+          - units_per_sec: throughput of the job (units / busy time)
+        The finished jobs are listed until reset_stats().
+        """
+        return _idaapi.idle_scheduler_get_stats(self.__sched)
+
+    def reset_stats(self):
+        """Forgets the finished jobs"""
+        _idaapi.idle_scheduler_reset_stats(self.__sched)
+
+
+
 #ICON WARNING|QUESTION|INFO|NONE
 #AUTOHIDE NONE|DATABASE|REGISTRY|SESSION
 #HIDECANCEL
@@ -12,6 +12,7 @@
 %ignore create_switch_xrefs;
 %ignore create_switch_table;
 %rename (calc_switch_cases)   py_calc_switch_cases;
+%rename (build_xref_graph)    py_build_xref_graph;
 
 // These functions should not be called directly (according to docs)
 %ignore xrefblk_t_first_from;
@@ -23,3 +24,133 @@
 %rename (frm) from;
 
 %include "xref.hpp"
+
+%{
+//<code(py_xref)>
+//-------------------------------------------------------------------------
+// Cross-references graph in compressed sparse row form:
+// the references of srcs[i] are tgts[offs[i]..offs[i+1]) (types[] alike)
+struct xref_graph_t
+{
+  eavec_t srcs;
+  qvector<uint32> offs;
+  eavec_t tgts;
+  bytevec_t types;
+};
+
+//-------------------------------------------------------------------------
+// Must be called without the GIL
+static void collect_xref_graph(
+        xref_graph_t *g,
+        ea_t ea1,
+        ea_t ea2,
+        bool want_code,
+        bool want_data,
+        bool want_flow)
+{
+  int xbflags = XREF_ALL;
+  if ( !want_flow )
+    xbflags |= XREF_FAR;
+  if ( !want_code && !want_flow )
+    xbflags |= XREF_DATA;
+
+  ea_t ea = ea1;
+  if ( ea < ea2 && !isHead(getFlags(ea)) )
+    ea = next_head(ea, ea2);
+  while ( ea < ea2 )
+  {
+    size_t nedges = g->tgts.size();
+    xrefblk_t xb;
+    for ( bool ok = xb.first_from(ea, xbflags); ok; ok = xb.next_from() )
+    {
+      bool keep;
+      if ( !xb.iscode )
+        keep = want_data;
+      else if ( xb.type == fl_F )
+        keep = want_flow;
+      else
+        keep = want_code;
+      if ( keep )
+      {
+        g->tgts.push_back(xb.to);
+        g->types.push_back(xb.type);
+      }
+    }
+    if ( g->tgts.size() != nedges )
+    {
+      g->srcs.push_back(ea);
+      g->offs.push_back(uint32(nedges));
+    }
+    ea = next_head(ea, ea2);
+  }
+  g->offs.push_back(uint32(g->tgts.size()));
+}
+//</code(py_xref)>
+%}
+
+%inline %{
+//<inline(py_xref)>
+#define XRG_CODE  0x01  // code references (calls and jumps)
+#define XRG_DATA  0x02  // data references
+#define XRG_FLOW  0x04  // ordinary flows to the next instruction
+
+/*
+#<pydoc>
+def build_xref_graph(flags = XRG_CODE|XRG_DATA, ea1 = inf.minEA, ea2 = inf.maxEA):
+    """
+    Collects the cross-references from all the heads in [ea1, ea2)
+    into a graph in compressed sparse row form.
+    Building a whole-database graph per segment is done by calling this
+    function with each segment's bounds.
+
+    @param flags: combination of XRG_... constants
+    @param ea1: start address
+    @param ea2: end address
+    @return: a tuple (srcs, offs, tgts, types) of array.array objects:
+             the references from srcs[i] go to tgts[offs[i]:offs[i+1]]
+             and have the types types[offs[i]:offs[i+1]] (fl_... or dr_...).
+             Only the heads with at least one reference appear in 'srcs'.
+             'srcs' and 'tgts' are lists if no array typecode
+             matches the size of ea_t.
+             None if the range is invalid.
+    """
+    pass
+#</pydoc>
+*/
+static PyObject *py_build_xref_graph(
+        int flags = XRG_CODE|XRG_DATA,
+        ea_t ea1 = BADADDR,
+        ea_t ea2 = BADADDR)
+{
+  PYW_GIL_CHECK_LOCKED_SCOPE();
+  if ( ea1 == BADADDR )
+    ea1 = inf.minEA;
+  if ( ea2 == BADADDR )
+    ea2 = inf.maxEA;
+  if ( ea1 >= ea2 )
+    Py_RETURN_NONE;
+
+  xref_graph_t g;
+  Py_BEGIN_ALLOW_THREADS;
+  collect_xref_graph(&g, ea1, ea2,
+                     (flags & XRG_CODE) != 0,
+                     (flags & XRG_DATA) != 0,
+                     (flags & XRG_FLOW) != 0);
+  Py_END_ALLOW_THREADS;
+
+  if ( g.tgts.size() > uint32(-1) )
+  {
+    PyErr_SetString(PyExc_OverflowError, "Too many cross-references");
+    return NULL;
+  }
+
+  newref_t py_srcs(eavec_to_pyarray(g.srcs));
+  newref_t py_offs(pyw_array_from_data("I", g.offs.begin(), g.offs.size()));
+  newref_t py_tgts(eavec_to_pyarray(g.tgts));
+  newref_t py_types(pyw_array_from_data("B", g.types.begin(), g.types.size()));
+  if ( py_srcs == NULL || py_offs == NULL || py_tgts == NULL || py_types == NULL )
+    return NULL;
+  return Py_BuildValue("(OOOO)", py_srcs.o, py_offs.o, py_tgts.o, py_types.o);
+}
+//</inline(py_xref)>
+%}